@@ -0,0 +1,61 @@
+# Compiles GLSL shaders to SPIR-V with glslc. Each <name> produces
+# ${CMAKE_CURRENT_BINARY_DIR}/shaders/<name>.inc, a comma separated list of
+# 32-bit words meant to be #included into a uint32_t array initializer.
+#
+#   compile_shaders(TARGET <target> SHADERS <file>...)
+#
+# Several targets of one directory may use the same shader; it is compiled
+# once, by the first of them, and the others depend on that target instead
+# of listing the output themselves, which would race under Makefiles.
+
+find_program(
+  GLSLC_EXECUTABLE glslc
+  HINTS $ENV{VULKAN_SDK}/bin $ENV{VULKAN_SDK}/Bin
+  DOC "Path to the glslc shader compiler")
+
+function(compile_shaders)
+  cmake_parse_arguments(ARG "" "TARGET" "SHADERS" ${ARGN})
+  if(NOT GLSLC_EXECUTABLE)
+    message(FATAL_ERROR "glslc is required to build ${ARG_TARGET}")
+  endif()
+
+  set(OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/shaders)
+  set(OUTPUTS)
+  set(OWNERS)
+  foreach(SHADER ${ARG_SHADERS})
+    get_filename_component(NAME ${SHADER} NAME)
+    set(OUTPUT ${OUTPUT_DIR}/${NAME}.inc)
+    # COMPILED_SHADER_OWNERS holds the target that compiles each entry of
+    # COMPILED_SHADER_OUTPUTS, at the same index.
+    get_property(COMPILED DIRECTORY PROPERTY COMPILED_SHADER_OUTPUTS)
+    list(FIND COMPILED ${OUTPUT} INDEX)
+    if(NOT INDEX EQUAL -1)
+      get_property(COMPILED_OWNERS DIRECTORY PROPERTY COMPILED_SHADER_OWNERS)
+      list(GET COMPILED_OWNERS ${INDEX} OWNER)
+      list(APPEND OWNERS ${OWNER})
+      continue()
+    endif()
+    list(APPEND OUTPUTS ${OUTPUT})
+    set_property(DIRECTORY APPEND PROPERTY COMPILED_SHADER_OUTPUTS ${OUTPUT})
+    set_property(DIRECTORY APPEND PROPERTY COMPILED_SHADER_OWNERS
+                 ${ARG_TARGET}_shaders)
+    add_custom_command(
+      OUTPUT ${OUTPUT}
+      COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+      COMMAND ${GLSLC_EXECUTABLE} --target-env=vulkan1.1 -O -mfmt=num -MD -MF
+              ${OUTPUT}.d -o ${OUTPUT} ${CMAKE_CURRENT_SOURCE_DIR}/${SHADER}
+      MAIN_DEPENDENCY ${SHADER}
+      DEPFILE ${OUTPUT}.d
+      COMMENT "Compiling shader ${NAME}"
+      VERBATIM)
+  endforeach()
+
+  add_custom_target(${ARG_TARGET}_shaders DEPENDS ${OUTPUTS})
+  if(OWNERS)
+    list(REMOVE_DUPLICATES OWNERS)
+    add_dependencies(${ARG_TARGET}_shaders ${OWNERS})
+  endif()
+  add_dependencies(${ARG_TARGET} ${ARG_TARGET}_shaders)
+  set_target_properties(${ARG_TARGET}_shaders PROPERTIES FOLDER Shaders)
+  target_include_directories(${ARG_TARGET} PRIVATE ${OUTPUT_DIR})
+endfunction()
@@ -34,6 +34,12 @@ class VulkanPlatform : public Platform {
 
   VkQueue getGraphicsQueue() const noexcept;
 
+  uint32_t getComputeQueueFamilyIndex() const noexcept;
+
+  uint32_t getComputeQueueIndex() const noexcept;
+
+  VkQueue getComputeQueue() const noexcept;
+
  private:
   static VkSurfaceKHR createVkSurfaceKHR(void* nativeWindow,
                                          VkInstance instance) noexcept;
@@ -44,6 +50,9 @@ class VulkanPlatform : public Platform {
   uint32_t mGraphicsQueueFamilyIndex;
   uint32_t mGraphicsQueueIndex;
   VkQueue mGraphicsQueue;
+  uint32_t mComputeQueueFamilyIndex;
+  uint32_t mComputeQueueIndex;
+  VkQueue mComputeQueue;
   VulkanContext mContext;
 };
 
@@ -1,12 +1,106 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "private/backend/DriverEnums.h"
+#include "private/backend/Handle.h"
+
 namespace engine::backend {
 
+// The driver is not thread safe; all calls must come from the same thread.
 class Driver {
  public:
   virtual ~Driver() noexcept;
 
   virtual void terminate() = 0;
+
+  virtual BufferObjectHandle createBufferObject(uint32_t byteCount,
+                                                BufferUsage usage) = 0;
+
+  virtual void updateBufferObject(BufferObjectHandle bo, void const* data,
+                                  uint32_t byteCount,
+                                  uint32_t byteOffset) = 0;
+
+  // Blocks until all previously submitted work is done, then copies the
+  // buffer contents to |data|.
+  virtual void readBufferObject(BufferObjectHandle bo, void* data,
+                                uint32_t byteCount, uint32_t byteOffset) = 0;
+
+  virtual void destroyBufferObject(BufferObjectHandle bo) = 0;
+
+  virtual TextureHandle createTexture(TextureFormat format, uint32_t width,
+                                      uint32_t height, uint8_t levels,
+                                      TextureUsage usage) = 0;
+
+  // |data| holds the tightly packed texels of one mip level.
+  virtual void updateTexture(TextureHandle th, uint8_t level,
+                             void const* data, size_t byteCount) = 0;
+
+  // Copies one mip level between textures of the same format on the GPU.
+  // Both levels must have the same dimensions.
+  virtual void copyTexture(TextureHandle dst, uint8_t dstLevel,
+                           TextureHandle src, uint8_t srcLevel) = 0;
+
+  virtual void destroyTexture(TextureHandle th) = 0;
+
+  virtual ProgramHandle createComputeProgram(
+      ComputeProgramDesc const& desc) = 0;
+
+  virtual void destroyProgram(ProgramHandle ph) = 0;
+
+  // Records the dispatches, together with any pending uploads, into a single
+  // submission on the compute queue. Compute runs on its own queue when the
+  // device has one, so it does not serialize with rendering.
+  virtual GpuFence dispatchCompute(ComputeDispatch const* dispatches,
+                                   size_t count) = 0;
+
+  // Submits everything recorded so far, such as uploads and readbacks, and
+  // returns the fence that signals its completion.
+  virtual GpuFence flush() = 0;
+
+  // Schedules a copy of the buffer range into driver-owned, host-cached
+  // memory without waiting for the GPU. The copy is submitted with the next
+  // flush or dispatch; polling does not submit it. Returns a null handle if
+  // the readback ring has no room left; release earlier readbacks to make
+  // space.
+  virtual ReadbackHandle readBufferObjectAsync(BufferObjectHandle bo,
+                                               uint32_t byteCount,
+                                               uint32_t byteOffset) = 0;
+
+  // Same as readBufferObjectAsync() for one mip level of a texture. The data
+  // is tightly packed with a row pitch of one row of texel blocks.
+  virtual ReadbackHandle readTextureAsync(TextureHandle th,
+                                          uint8_t level) = 0;
+
+  // Non-blocking, and submits nothing: a readback recorded since the last
+  // flush or dispatch stays not ready until the caller flushes.
+  virtual bool isReadbackReady(ReadbackHandle rh) = 0;
+
+  // Zero-copy view of the data; empty until the readback is ready.
+  virtual ReadbackView getReadbackView(ReadbackHandle rh) = 0;
+
+  // Returns the readback memory to the ring. The view must not be used
+  // afterwards.
+  virtual void releaseReadback(ReadbackHandle rh) = 0;
+
+  virtual MemoryBudget getMemoryBudget() = 0;
+
+  virtual MemoryFragmentation getMemoryFragmentation() = 0;
+
+  // Incrementally compacts device memory. Buffer objects and textures in
+  // sparsely used blocks are recreated elsewhere and their contents copied
+  // on the GPU, at most |maxBytes| per call but always at least one
+  // resource, so that the emptied blocks can be released. Call once per
+  // frame. Handles stay valid and commands recorded afterwards use the new
+  // memory.
+  virtual DefragmentationStats defragment(uint64_t maxBytes) = 0;
+
+  // Non-blocking completion query.
+  virtual bool isSignaled(GpuFence fence) = 0;
+
+  // Returns false if |timeoutNs| elapsed before the fence was signaled.
+  virtual bool wait(GpuFence fence, uint64_t timeoutNs) = 0;
 };
 
 }  // namespace engine::backend
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "private/backend/Handle.h"
+
+namespace engine::backend {
+
+// Minimum maxPushConstantsSize guaranteed by Vulkan.
+constexpr size_t MAX_PUSH_CONSTANT_SIZE = 128;
+
+enum class BufferUsage : uint8_t {
+  STORAGE = 0x1,
+  UNIFORM = 0x2,
+  VERTEX = 0x4,
+  INDEX = 0x8,
+  INDIRECT = 0x10,
+};
+
+enum class TextureFormat : uint8_t {
+  R8,
+  RG8,
+  RGBA8,
+  RGBA8_SRGB,
+  R16F,
+  RGBA16F,
+  R32F,
+  RG32F,
+  RGBA32F,
+  R32UI,
+  BC1_RGBA,
+  BC3_RGBA,
+  BC7_RGBA,
+};
+
+enum class TextureUsage : uint8_t {
+  SAMPLEABLE = 0x1,
+  STORAGE = 0x2,
+  UPLOADABLE = 0x4,
+  READABLE = 0x8,
+};
+
+enum class DescriptorType : uint8_t {
+  STORAGE_BUFFER,
+  UNIFORM_BUFFER,
+  STORAGE_IMAGE,
+  SAMPLED_IMAGE,
+};
+
+inline BufferUsage operator|(BufferUsage lhs, BufferUsage rhs) noexcept {
+  return BufferUsage(uint8_t(lhs) | uint8_t(rhs));
+}
+
+inline bool any(BufferUsage usage, BufferUsage bits) noexcept {
+  return (uint8_t(usage) & uint8_t(bits)) != 0;
+}
+
+inline TextureUsage operator|(TextureUsage lhs, TextureUsage rhs) noexcept {
+  return TextureUsage(uint8_t(lhs) | uint8_t(rhs));
+}
+
+inline bool any(TextureUsage usage, TextureUsage bits) noexcept {
+  return (uint8_t(usage) & uint8_t(bits)) != 0;
+}
+
+// A compute shader and the layout of descriptor set 0. Binding i of the set
+// has type bindings[i].
+struct ComputeProgramDesc {
+  uint32_t const* spirv = nullptr;
+  size_t spirvSize = 0;  // in bytes
+  char const* entryPoint = "main";
+  std::vector<DescriptorType> bindings;
+  uint32_t pushConstantSize = 0;
+};
+
+struct ComputeBinding {
+  uint32_t binding = 0;
+  // Exactly one of buffer or texture is set.
+  BufferObjectHandle buffer;
+  uint32_t offset = 0;
+  uint32_t size = 0;  // 0 binds the rest of the buffer
+  TextureHandle texture;
+  uint8_t level = 0;  // mip level bound as a storage image
+};
+
+struct ComputeDispatch {
+  ProgramHandle program;
+  std::vector<ComputeBinding> bindings;
+  uint8_t pushConstants[MAX_PUSH_CONSTANT_SIZE] = {};
+  uint32_t pushConstantSize = 0;
+  uint32_t groupCount[3] = {1, 1, 1};
+  // When set, group counts are read from a VkDispatchIndirectCommand at
+  // indirectOffset in this buffer instead.
+  BufferObjectHandle indirectBuffer;
+  uint32_t indirectOffset = 0;
+  // Wait for the memory writes of everything recorded before this dispatch.
+  // Clear it for dispatches that are independent of their predecessors.
+  bool barrier = true;
+
+  // Records |size| even when it exceeds MAX_PUSH_CONSTANT_SIZE, so that
+  // dispatchCompute() rejects the dispatch instead of pushing a truncated
+  // block.
+  void setPushConstants(void const* data, uint32_t size) noexcept {
+    pushConstantSize = size;
+    memcpy(pushConstants, data,
+           size < MAX_PUSH_CONSTANT_SIZE ? size
+                                         : uint32_t(MAX_PUSH_CONSTANT_SIZE));
+  }
+};
+
+// Device-local memory of the whole process, summed over heaps.
+struct MemoryBudget {
+  // How much the process can allocate before the OS starts demoting or
+  // failing allocations. 0 when the device does not report a budget
+  // (VK_EXT_memory_budget is missing).
+  uint64_t budget = 0;
+  uint64_t usage = 0;
+};
+
+// Shared device-local memory blocks of the driver allocator. Resources
+// large enough to get a block of their own are not counted.
+struct MemoryFragmentation {
+  uint64_t blockBytes = 0;
+  uint64_t usedBytes = 0;
+  uint64_t largestFreeRange = 0;
+  uint32_t blockCount = 0;
+  // 1 - largestFreeRange / free bytes: 0 when all free space is contiguous,
+  // close to 1 when it is scattered in small holes.
+  float fragmentation = 0.0f;
+};
+
+// Work done by one Driver::defragment() call.
+struct DefragmentationStats {
+  uint64_t bytesMoved = 0;
+  uint32_t resourcesMoved = 0;
+  // Blocks still being emptied after this call.
+  uint32_t blocksEvacuating = 0;
+};
+
+// CPU view of a completed readback. The memory is owned by the driver and
+// stays valid until the readback is released.
+struct ReadbackView {
+  void const* data = nullptr;
+  size_t byteCount = 0;
+  // Bytes between rows of texel blocks for texture readbacks, 0 for buffers.
+  uint32_t rowPitch = 0;
+};
+
+// Completion point of GPU work; signaled once the work that produced it is
+// done. A default-constructed fence is always signaled.
+struct GpuFence {
+  uint64_t value = 0;
+};
+
+}  // namespace engine::backend
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace engine::backend {
+
+struct HwBufferObject;
+struct HwTexture;
+struct HwProgram;
+struct HwReadback;
+
+// Opaque, typed reference to a driver-owned resource. Ids are reused once
+// their resource is destroyed; the generation tells a stale handle apart
+// from the one that now owns the id.
+template <typename T>
+class Handle {
+ public:
+  using HandleId = uint32_t;
+  static constexpr HandleId nullid = UINT32_MAX;
+
+  Handle() noexcept = default;
+
+  explicit Handle(HandleId id, uint32_t generation = 0) noexcept
+      : mId(id), mGeneration(generation) {}
+
+  explicit operator bool() const noexcept { return mId != nullid; }
+
+  HandleId getId() const noexcept { return mId; }
+  uint32_t getGeneration() const noexcept { return mGeneration; }
+
+  bool operator==(Handle const& rhs) const noexcept {
+    return mId == rhs.mId && mGeneration == rhs.mGeneration;
+  }
+  bool operator!=(Handle const& rhs) const noexcept { return !(*this == rhs); }
+
+ private:
+  HandleId mId = nullid;
+  uint32_t mGeneration = 0;
+};
+
+using BufferObjectHandle = Handle<HwBufferObject>;
+using TextureHandle = Handle<HwTexture>;
+using ProgramHandle = Handle<HwProgram>;
+using ReadbackHandle = Handle<HwReadback>;
+
+}  // namespace engine::backend
@@ -0,0 +1,242 @@
+#include "VulkanCommands.h"
+
+#include <assert.h>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "metrics/Metrics.h"
+
+namespace engine::backend {
+
+using metrics::Counter;
+using metrics::Histogram;
+using metrics::Metrics;
+
+namespace {
+
+constexpr uint32_t DESCRIPTOR_POOL_MAX_SETS = 256;
+
+constexpr VkDescriptorPoolSize DESCRIPTOR_POOL_SIZES[] = {
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1024},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 256},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 512},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 512},
+};
+
+}  // anonymous namespace
+
+VulkanCommands::VulkanCommands(VkDevice device, uint32_t queueFamilyIndex,
+                               VkQueue queue) noexcept
+    : mDevice(device), mQueue(queue) {
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT |
+                   VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  poolInfo.queueFamilyIndex = queueFamilyIndex;
+  VkResult result =
+      vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mCommandPool);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateCommandPool error=" << static_cast<int32_t>(result);
+
+  VkSemaphoreTypeCreateInfoKHR typeInfo{};
+  typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+  typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+  typeInfo.initialValue = 0;
+  VkSemaphoreCreateInfo semaphoreInfo{};
+  semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphoreInfo.pNext = &typeInfo;
+  result = vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &mTimeline);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateSemaphore error=" << static_cast<int32_t>(result);
+}
+
+VulkanCommands::~VulkanCommands() noexcept {
+  assert(mCommandPool == VK_NULL_HANDLE);
+}
+
+void VulkanCommands::terminate() noexcept {
+  if (mCommandPool == VK_NULL_HANDLE) {
+    return;
+  }
+  flush();
+  wait(mSubmittedValue, UINT64_MAX);
+  gc();
+  for (VkDescriptorPool pool : mFreeDescriptorPools) {
+    vkDestroyDescriptorPool(mDevice, pool, nullptr);
+  }
+  mFreeDescriptorPools.clear();
+  mFreeCommandBuffers.clear();
+  vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+  vkDestroySemaphore(mDevice, mTimeline, nullptr);
+  mCommandPool = VK_NULL_HANDLE;
+  mTimeline = VK_NULL_HANDLE;
+}
+
+VkCommandBuffer VulkanCommands::get() {
+  if (mCurrent) {
+    return mCurrent->commandBuffer;
+  }
+  mCurrent = std::make_unique<Submission>();
+  if (!mFreeCommandBuffers.empty()) {
+    mCurrent->commandBuffer = mFreeCommandBuffers.back();
+    mFreeCommandBuffers.pop_back();
+  } else {
+    VkCommandBufferAllocateInfo allocateInfo{};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.commandPool = mCommandPool;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandBufferCount = 1;
+    VkResult result = vkAllocateCommandBuffers(mDevice, &allocateInfo,
+                                               &mCurrent->commandBuffer);
+    CHECK(result == VK_SUCCESS)
+        << "vkAllocateCommandBuffers error=" << static_cast<int32_t>(result);
+  }
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkBeginCommandBuffer(mCurrent->commandBuffer, &beginInfo);
+  return mCurrent->commandBuffer;
+}
+
+VkDescriptorPool VulkanCommands::acquireDescriptorPool() {
+  if (!mFreeDescriptorPools.empty()) {
+    VkDescriptorPool pool = mFreeDescriptorPools.back();
+    mFreeDescriptorPools.pop_back();
+    return pool;
+  }
+  VkDescriptorPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.maxSets = DESCRIPTOR_POOL_MAX_SETS;
+  poolInfo.poolSizeCount =
+      sizeof(DESCRIPTOR_POOL_SIZES) / sizeof(DESCRIPTOR_POOL_SIZES[0]);
+  poolInfo.pPoolSizes = DESCRIPTOR_POOL_SIZES;
+  VkDescriptorPool pool;
+  VkResult result = vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &pool);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateDescriptorPool error=" << static_cast<int32_t>(result);
+  return pool;
+}
+
+VkDescriptorSet VulkanCommands::allocateDescriptorSet(
+    VkDescriptorSetLayout layout) {
+  get();
+  auto& pools = mCurrent->descriptorPools;
+  VkDescriptorSetAllocateInfo allocateInfo{};
+  allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocateInfo.descriptorSetCount = 1;
+  allocateInfo.pSetLayouts = &layout;
+
+  VkDescriptorSet set = VK_NULL_HANDLE;
+  if (!pools.empty()) {
+    allocateInfo.descriptorPool = pools.back();
+    if (vkAllocateDescriptorSets(mDevice, &allocateInfo, &set) ==
+        VK_SUCCESS) {
+      return set;
+    }
+  }
+  // The current pool is exhausted (or there is none yet).
+  pools.push_back(acquireDescriptorPool());
+  allocateInfo.descriptorPool = pools.back();
+  VkResult result = vkAllocateDescriptorSets(mDevice, &allocateInfo, &set);
+  CHECK(result == VK_SUCCESS)
+      << "vkAllocateDescriptorSets error=" << static_cast<int32_t>(result);
+  return set;
+}
+
+uint64_t VulkanCommands::flush() {
+  if (!mCurrent) {
+    return mSubmittedValue;
+  }
+  VkCommandBuffer const cmdbuf = mCurrent->commandBuffer;
+  vkEndCommandBuffer(cmdbuf);
+
+  uint64_t const signalValue = mSubmittedValue + 1;
+  VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+  timelineInfo.signalSemaphoreValueCount = 1;
+  timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.pNext = &timelineInfo;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &cmdbuf;
+  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.pSignalSemaphores = &mTimeline;
+  VkResult result;
+  {
+    metrics::ScopedTimer timer(Histogram::QUEUE_SUBMIT_NS);
+    result = vkQueueSubmit(mQueue, 1, &submitInfo, VK_NULL_HANDLE);
+  }
+  CHECK(result == VK_SUCCESS)
+      << "vkQueueSubmit error=" << static_cast<int32_t>(result);
+  Metrics::add(Counter::SUBMITS);
+  if (Metrics::isEnabled()) {
+    mCurrent->submitTime = std::chrono::steady_clock::now();
+  }
+
+  mSubmittedValue = signalValue;
+  mCurrent->value = signalValue;
+  mInFlight.push_back(std::move(mCurrent));
+  return signalValue;
+}
+
+uint64_t VulkanCommands::getCompletedValue() const noexcept {
+  uint64_t value = 0;
+  vkGetSemaphoreCounterValueKHR(mDevice, mTimeline, &value);
+  return value;
+}
+
+bool VulkanCommands::wait(uint64_t value, uint64_t timeoutNs) const noexcept {
+  if (value > mSubmittedValue) {
+    LOG(ERROR) << "Waiting on timeline value " << value
+               << " that was never submitted.";
+    return false;
+  }
+  VkSemaphoreWaitInfoKHR waitInfo{};
+  waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+  waitInfo.semaphoreCount = 1;
+  waitInfo.pSemaphores = &mTimeline;
+  waitInfo.pValues = &value;
+  return vkWaitSemaphoresKHR(mDevice, &waitInfo, timeoutNs) == VK_SUCCESS;
+}
+
+void VulkanCommands::defer(std::function<void()> callback) {
+  mDeferred.emplace_back(getRecordingValue(), std::move(callback));
+}
+
+void VulkanCommands::recycle(Submission& submission) {
+  if (Metrics::isEnabled() &&
+      submission.submitTime.time_since_epoch().count()) {
+    // Completion is only noticed here, so this is an upper bound.
+    auto const latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - submission.submitTime);
+    Metrics::record(Histogram::SUBMIT_COMPLETE_NS,
+                    static_cast<uint64_t>(latency.count()));
+  }
+  submission.submitTime = {};
+  vkResetCommandBuffer(submission.commandBuffer, 0);
+  mFreeCommandBuffers.push_back(submission.commandBuffer);
+  for (VkDescriptorPool pool : submission.descriptorPools) {
+    vkResetDescriptorPool(mDevice, pool, 0);
+    mFreeDescriptorPools.push_back(pool);
+  }
+}
+
+void VulkanCommands::gc() {
+  uint64_t const completed = getCompletedValue();
+  while (!mInFlight.empty() && mInFlight.front()->value <= completed) {
+    recycle(*mInFlight.front());
+    mInFlight.pop_front();
+  }
+  // Deferred values are recorded in submission order, so they never
+  // decrease along the queue.
+  while (!mDeferred.empty() && mDeferred.front().first <= completed) {
+    auto callback = std::move(mDeferred.front().second);
+    mDeferred.pop_front();
+    callback();
+  }
+}
+
+}  // namespace engine::backend
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "volk.h"
+
+namespace engine::backend {
+
+// Records and submits work to one queue. Every submission signals the next
+// value of a timeline semaphore, which is what GpuFence values refer to.
+// Command buffers and descriptor pools are recycled once their submission
+// has completed.
+class VulkanCommands {
+ public:
+  VulkanCommands(VkDevice device, uint32_t queueFamilyIndex,
+                 VkQueue queue) noexcept;
+  ~VulkanCommands() noexcept;
+
+  VulkanCommands(VulkanCommands const&) = delete;
+  VulkanCommands& operator=(VulkanCommands const&) = delete;
+
+  // Waits for the queue to drain and releases every Vulkan object.
+  void terminate() noexcept;
+
+  // Command buffer currently recording; begun on first use.
+  VkCommandBuffer get();
+
+  // Allocates a descriptor set that stays valid until the current command
+  // buffer has finished executing.
+  VkDescriptorSet allocateDescriptorSet(VkDescriptorSetLayout layout);
+
+  // Submits the current command buffer, if any, and returns the timeline
+  // value that will be signaled once everything submitted so far is done.
+  uint64_t flush();
+
+  uint64_t getSubmittedValue() const noexcept { return mSubmittedValue; }
+
+  // Value the work recorded so far will signal once it completes.
+  uint64_t getRecordingValue() const noexcept {
+    return mCurrent ? mSubmittedValue + 1 : mSubmittedValue;
+  }
+
+  uint64_t getCompletedValue() const noexcept;
+
+  bool wait(uint64_t value, uint64_t timeoutNs) const noexcept;
+
+  // Runs |callback| once the GPU is done with all work recorded so far,
+  // including the command buffer still being recorded.
+  void defer(std::function<void()> callback);
+
+  // Recycles completed submissions and runs due deferred callbacks.
+  void gc();
+
+  VkSemaphore getTimelineSemaphore() const noexcept { return mTimeline; }
+
+  VkQueue getQueue() const noexcept { return mQueue; }
+
+ private:
+  struct Submission {
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPool> descriptorPools;
+    uint64_t value = 0;
+    // Only set while metrics are enabled.
+    std::chrono::steady_clock::time_point submitTime;
+  };
+
+  VkDescriptorPool acquireDescriptorPool();
+
+  void recycle(Submission& submission);
+
+  VkDevice const mDevice;
+  VkQueue const mQueue;
+  VkCommandPool mCommandPool = VK_NULL_HANDLE;
+  VkSemaphore mTimeline = VK_NULL_HANDLE;
+  uint64_t mSubmittedValue = 0;
+
+  std::unique_ptr<Submission> mCurrent;
+  std::deque<std::unique_ptr<Submission>> mInFlight;
+  std::vector<VkCommandBuffer> mFreeCommandBuffers;
+  std::vector<VkDescriptorPool> mFreeDescriptorPools;
+  std::deque<std::pair<uint64_t, std::function<void()>>> mDeferred;
+};
+
+}  // namespace engine::backend
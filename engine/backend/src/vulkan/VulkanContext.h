@@ -10,8 +10,33 @@ struct VulkanContext {
     return mDebugUtilsSupported;
   }
 
+  inline VkPhysicalDeviceProperties const& getPhysicalDeviceProperties()
+      const noexcept {
+    return mPhysicalDeviceProperties;
+  }
+
+  inline VkPhysicalDeviceMemoryProperties const& getMemoryProperties()
+      const noexcept {
+    return mMemoryProperties;
+  }
+
+  // VK_EXT_memory_budget is enabled.
+  inline bool isMemoryBudgetSupported() const noexcept {
+    return mMemoryBudgetSupported;
+  }
+
+  // True when compute has a queue of its own rather than sharing the
+  // graphics queue.
+  inline bool hasDedicatedComputeQueue() const noexcept {
+    return mDedicatedComputeQueue;
+  }
+
  private:
   bool mDebugUtilsSupported = false;
+  bool mDedicatedComputeQueue = false;
+  bool mMemoryBudgetSupported = false;
+  VkPhysicalDeviceProperties mPhysicalDeviceProperties = {};
+  VkPhysicalDeviceMemoryProperties mMemoryProperties = {};
 
   friend class VulkanPlatform;
 };
@@ -1,14 +1,42 @@
 #include "VulkanDriver.h"
 
 #include <backend/platforms/VulkanPlatform.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
 
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "metrics/Metrics.h"
+#include "vulkan/utils/Conversion.h"
 
 namespace engine::backend {
 
+using metrics::Counter;
+using metrics::Metrics;
+
 namespace {
 
+// Enough for three 4K RGBA8 frames in flight.
+constexpr VkDeviceSize READBACK_RING_SIZE = 128ull * 1024 * 1024;
+// Keeps every readback on its own non-coherent atom and satisfies the copy
+// offset rules of all texel block sizes.
+constexpr VkDeviceSize READBACK_ALIGNMENT = 256;
+// Blocks fuller than this are not worth emptying.
+constexpr float DEFRAGMENT_MAX_OCCUPANCY = 0.5f;
+
+// Readback ids count up without wrapping. They are spread over the id and
+// the generation of the handle so that none of them maps to the null id.
+ReadbackHandle toReadbackHandle(uint64_t id) noexcept {
+  return ReadbackHandle(uint32_t(id % ReadbackHandle::nullid),
+                        uint32_t(id / ReadbackHandle::nullid));
+}
+
+uint64_t toReadbackId(ReadbackHandle rh) noexcept {
+  return uint64_t(rh.getGeneration()) * ReadbackHandle::nullid + rh.getId();
+}
+
 #ifndef NDEBUG
 VKAPI_ATTR VkBool32 VKAPI_CALL debugUtilsCallback(
     VkDebugUtilsMessageSeverityFlagBitsEXT severity,
@@ -82,11 +110,36 @@ void DebugUtils::setName(VkObjectType type, uint64_t handle, char const* name) {
 
 inline VulkanDriver::VulkanDriver(VulkanPlatform* mPlatform,
                                   VulkanContext const& context) noexcept
-    : mPlatform(mPlatform), mContext(context) {
+    : mPlatform(mPlatform),
+      mContext(context),
+      mDevice(mPlatform->getDevice()) {
 #ifndef NDEBUG
   DebugUtils::mSingleton =
       new DebugUtils(mPlatform->getInstance(), VK_NULL_HANDLE, &context);
 #endif
+
+  mQueueFamilies.indices[0] = mPlatform->getGraphicsQueueFamilyIndex();
+  mQueueFamilies.indices[1] = mPlatform->getComputeQueueFamilyIndex();
+  mQueueFamilies.count =
+      mQueueFamilies.indices[0] == mQueueFamilies.indices[1] ? 1 : 2;
+
+  mAllocator = std::make_unique<VulkanAllocator>(mDevice, mContext);
+  mCommands = std::make_unique<VulkanCommands>(
+      mDevice, mPlatform->getComputeQueueFamilyIndex(),
+      mPlatform->getComputeQueue());
+
+  VkSamplerCreateInfo samplerInfo{};
+  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  samplerInfo.magFilter = VK_FILTER_LINEAR;
+  samplerInfo.minFilter = VK_FILTER_LINEAR;
+  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+  VkResult result = vkCreateSampler(mDevice, &samplerInfo, nullptr, &mSampler);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateSampler error=" << static_cast<int32_t>(result);
 }
 
 VulkanDriver::~VulkanDriver() noexcept = default;
@@ -97,6 +150,31 @@ Driver* engine::backend::VulkanDriver::create(
 }
 
 void VulkanDriver::terminate() {
+  vkDeviceWaitIdle(mDevice);
+
+  // Runs the pending deferred destructions before the tables are emptied.
+  mCommands->terminate();
+  mCommands.reset();
+
+  mBufferObjects.forEach(
+      [this](VulkanBufferObject& bo) { bo.destroy(mDevice, *mAllocator); });
+  mBufferObjects.clear();
+  mTextures.forEach([this](VulkanTexture& texture) {
+    texture.destroy(mDevice, *mAllocator);
+  });
+  mTextures.clear();
+  mPrograms.forEach(
+      [this](VulkanProgram& program) { program.destroy(mDevice); });
+  mPrograms.clear();
+  if (mReadbacks) {
+    mReadbacks->terminate();
+    mReadbacks.reset();
+  }
+
+  vkDestroySampler(mDevice, mSampler, nullptr);
+  mSampler = VK_NULL_HANDLE;
+  mAllocator.reset();
+
 #ifndef NDEBUG
   assert(DebugUtils::mSingleton);
   delete DebugUtils::mSingleton;
@@ -105,4 +183,633 @@ void VulkanDriver::terminate() {
   mPlatform->terminate();
 }
 
+void VulkanDriver::memoryBarrier(VkCommandBuffer cmdbuf,
+                                 VkPipelineStageFlags dstStage,
+                                 VkAccessFlags dstAccess) noexcept {
+  VkMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask =
+      VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = dstAccess;
+  vkCmdPipelineBarrier(
+      cmdbuf,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+      dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+  Metrics::add(Counter::BARRIERS);
+}
+
+void VulkanDriver::hostBarrier(VkCommandBuffer cmdbuf) noexcept {
+  VkMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr,
+                       0, nullptr);
+  Metrics::add(Counter::BARRIERS);
+}
+
+BufferObjectHandle VulkanDriver::createBufferObject(uint32_t byteCount,
+                                                    BufferUsage usage) {
+  auto bo = std::make_unique<VulkanBufferObject>(
+      mDevice, *mAllocator, mQueueFamilies, byteCount, usage);
+  return mBufferObjects.insert(std::move(bo));
+}
+
+void VulkanDriver::updateBufferObject(BufferObjectHandle bo, void const* data,
+                                      uint32_t byteCount,
+                                      uint32_t byteOffset) {
+  VulkanBufferObject* buffer = mBufferObjects.get(bo);
+  CHECK(buffer) << "Invalid buffer object handle.";
+  if (byteCount == 0) {
+    return;
+  }
+  if (uint64_t(byteOffset) + byteCount > buffer->byteCount) {
+    LOG(ERROR) << "Buffer update out of range: offset=" << byteOffset
+               << " size=" << byteCount << " capacity=" << buffer->byteCount;
+    return;
+  }
+
+  auto* stage = new VulkanStage(mDevice, *mAllocator, byteCount, false);
+  memcpy(stage->allocation.mapped, data, byteCount);
+  mAllocator->flush(stage->allocation, 0, byteCount);
+
+  VkCommandBuffer cmdbuf = mCommands->get();
+  memoryBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT);
+  VkBufferCopy region{0, byteOffset, byteCount};
+  vkCmdCopyBuffer(cmdbuf, stage->buffer, buffer->buffer, 1, &region);
+  mTransferPending = true;
+  Metrics::add(Counter::BYTES_UPLOADED, byteCount);
+
+  mCommands->defer([this, stage]() {
+    stage->destroy(mDevice, *mAllocator);
+    delete stage;
+  });
+}
+
+void VulkanDriver::readBufferObject(BufferObjectHandle bo, void* data,
+                                    uint32_t byteCount, uint32_t byteOffset) {
+  VulkanBufferObject* buffer = mBufferObjects.get(bo);
+  CHECK(buffer) << "Invalid buffer object handle.";
+  if (byteCount == 0) {
+    return;
+  }
+  if (uint64_t(byteOffset) + byteCount > buffer->byteCount) {
+    LOG(ERROR) << "Buffer read out of range: offset=" << byteOffset
+               << " size=" << byteCount << " capacity=" << buffer->byteCount;
+    return;
+  }
+
+  VulkanStage stage(mDevice, *mAllocator, byteCount, true);
+  VkCommandBuffer cmdbuf = mCommands->get();
+  memoryBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT);
+  VkBufferCopy region{byteOffset, 0, byteCount};
+  vkCmdCopyBuffer(cmdbuf, buffer->buffer, stage.buffer, 1, &region);
+
+  hostBarrier(cmdbuf);
+
+  uint64_t const value = mCommands->flush();
+  mCommands->wait(value, UINT64_MAX);
+  mAllocator->invalidate(stage.allocation, 0, byteCount);
+  memcpy(data, stage.allocation.mapped, byteCount);
+  stage.destroy(mDevice, *mAllocator);
+  mCommands->gc();
+}
+
+void VulkanDriver::destroyBufferObject(BufferObjectHandle bo) {
+  if (!bo) {
+    return;
+  }
+  VulkanBufferObject* buffer = mBufferObjects.remove(bo).release();
+  if (!buffer) {
+    LOG(ERROR) << "Destroying invalid buffer object handle " << bo.getId();
+    return;
+  }
+  mCommands->defer([this, buffer]() {
+    buffer->destroy(mDevice, *mAllocator);
+    delete buffer;
+  });
+}
+
+TextureHandle VulkanDriver::createTexture(TextureFormat format, uint32_t width,
+                                          uint32_t height, uint8_t levels,
+                                          TextureUsage usage) {
+  auto texture = std::make_unique<VulkanTexture>(
+      mDevice, *mAllocator, mQueueFamilies, format, width, height, levels,
+      usage);
+  initializeLayout(mCommands->get(), *texture);
+  return mTextures.insert(std::move(texture));
+}
+
+void VulkanDriver::initializeLayout(VkCommandBuffer cmdbuf,
+                                    VulkanTexture const& texture) noexcept {
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                          VK_ACCESS_SHADER_WRITE_BIT |
+                          VK_ACCESS_TRANSFER_READ_BIT |
+                          VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = texture.image;
+  barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.levels, 0,
+                              1};
+  vkCmdPipelineBarrier(
+      cmdbuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+      0, nullptr, 0, nullptr, 1, &barrier);
+  Metrics::add(Counter::BARRIERS);
+}
+
+void VulkanDriver::updateTexture(TextureHandle th, uint8_t level,
+                                 void const* data, size_t byteCount) {
+  VulkanTexture* texture = mTextures.get(th);
+  CHECK(texture) << "Invalid texture handle.";
+  if (level >= texture->levels) {
+    LOG(ERROR) << "Texture update of missing level " << uint32_t(level);
+    return;
+  }
+  uint64_t const levelSize = vkutils::getLevelSize(
+      texture->format, texture->width, texture->height, level);
+  if (byteCount != levelSize) {
+    LOG(ERROR) << "Texture update size mismatch: got " << byteCount
+               << " bytes, level " << uint32_t(level) << " needs "
+               << levelSize;
+    return;
+  }
+
+  auto* stage = new VulkanStage(mDevice, *mAllocator, byteCount, false);
+  memcpy(stage->allocation.mapped, data, byteCount);
+  mAllocator->flush(stage->allocation, 0, byteCount);
+
+  VkCommandBuffer cmdbuf = mCommands->get();
+  memoryBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT);
+  VkBufferImageCopy region{};
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+  region.imageExtent = {std::max(texture->width >> level, 1u),
+                        std::max(texture->height >> level, 1u), 1};
+  vkCmdCopyBufferToImage(cmdbuf, stage->buffer, texture->image,
+                         VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+  mTransferPending = true;
+  Metrics::add(Counter::BYTES_UPLOADED, byteCount);
+
+  mCommands->defer([this, stage]() {
+    stage->destroy(mDevice, *mAllocator);
+    delete stage;
+  });
+}
+
+void VulkanDriver::copyTexture(TextureHandle dst, uint8_t dstLevel,
+                               TextureHandle src, uint8_t srcLevel) {
+  VulkanTexture* dstTexture = mTextures.get(dst);
+  VulkanTexture* srcTexture = mTextures.get(src);
+  CHECK(dstTexture && srcTexture) << "Invalid texture handle.";
+  uint32_t const width = std::max(srcTexture->width >> srcLevel, 1u);
+  uint32_t const height = std::max(srcTexture->height >> srcLevel, 1u);
+  if (dstLevel >= dstTexture->levels || srcLevel >= srcTexture->levels ||
+      dstTexture->format != srcTexture->format ||
+      width != std::max(dstTexture->width >> dstLevel, 1u) ||
+      height != std::max(dstTexture->height >> dstLevel, 1u)) {
+    LOG(ERROR) << "Incompatible texture copy from level "
+               << uint32_t(srcLevel) << " to level " << uint32_t(dstLevel);
+    return;
+  }
+
+  VkCommandBuffer cmdbuf = mCommands->get();
+  memoryBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+  VkImageCopy region{};
+  region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, srcLevel, 0, 1};
+  region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, dstLevel, 0, 1};
+  region.extent = {width, height, 1};
+  vkCmdCopyImage(cmdbuf, srcTexture->image, VK_IMAGE_LAYOUT_GENERAL,
+                 dstTexture->image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+  mTransferPending = true;
+}
+
+void VulkanDriver::destroyTexture(TextureHandle th) {
+  if (!th) {
+    return;
+  }
+  VulkanTexture* texture = mTextures.remove(th).release();
+  if (!texture) {
+    LOG(ERROR) << "Destroying invalid texture handle " << th.getId();
+    return;
+  }
+  mCommands->defer([this, texture]() {
+    texture->destroy(mDevice, *mAllocator);
+    delete texture;
+  });
+}
+
+ProgramHandle VulkanDriver::createComputeProgram(
+    ComputeProgramDesc const& desc) {
+  CHECK(desc.pushConstantSize <= MAX_PUSH_CONSTANT_SIZE)
+      << "Push constant block of " << desc.pushConstantSize
+      << " bytes exceeds the limit.";
+  auto program = std::make_unique<VulkanProgram>(mDevice, desc);
+  return mPrograms.insert(std::move(program));
+}
+
+void VulkanDriver::destroyProgram(ProgramHandle ph) {
+  if (!ph) {
+    return;
+  }
+  VulkanProgram* program = mPrograms.remove(ph).release();
+  if (!program) {
+    LOG(ERROR) << "Destroying invalid program handle " << ph.getId();
+    return;
+  }
+  mCommands->defer([this, program]() {
+    program->destroy(mDevice);
+    delete program;
+  });
+}
+
+void VulkanDriver::bindDescriptors(VkCommandBuffer cmdbuf,
+                                   VulkanProgram const& program,
+                                   ComputeDispatch const& dispatch) {
+  if (program.bindings.empty()) {
+    return;
+  }
+  size_t const count = dispatch.bindings.size();
+  // Reserved up front so the pointers stored in the writes stay valid.
+  std::vector<VkDescriptorBufferInfo> bufferInfos;
+  std::vector<VkDescriptorImageInfo> imageInfos;
+  std::vector<VkWriteDescriptorSet> writes;
+  bufferInfos.reserve(count);
+  imageInfos.reserve(count);
+  writes.reserve(count);
+
+  VkDescriptorSet set =
+      mCommands->allocateDescriptorSet(program.descriptorSetLayout);
+  for (ComputeBinding const& binding : dispatch.bindings) {
+    CHECK(binding.binding < program.bindings.size())
+        << "Binding " << binding.binding << " is not declared by the program.";
+    DescriptorType const type = program.bindings[binding.binding];
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = binding.binding;
+    write.descriptorCount = 1;
+    write.descriptorType = vkutils::getVkDescriptorType(type);
+
+    if (type == DescriptorType::STORAGE_BUFFER ||
+        type == DescriptorType::UNIFORM_BUFFER) {
+      VulkanBufferObject* buffer = mBufferObjects.get(binding.buffer);
+      CHECK(buffer) << "Binding " << binding.binding << " has no buffer.";
+      bufferInfos.push_back({buffer->buffer, binding.offset,
+                             binding.size ? binding.size : VK_WHOLE_SIZE});
+      write.pBufferInfo = &bufferInfos.back();
+    } else {
+      VulkanTexture* texture = mTextures.get(binding.texture);
+      CHECK(texture) << "Binding " << binding.binding << " has no texture.";
+      VkDescriptorImageInfo info{};
+      info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+      if (type == DescriptorType::STORAGE_IMAGE) {
+        CHECK(binding.level < texture->levelViews.size())
+            << "Texture is not a storage image or lacks level "
+            << uint32_t(binding.level);
+        info.imageView = texture->levelViews[binding.level];
+      } else {
+        info.sampler = mSampler;
+        info.imageView = texture->view;
+      }
+      imageInfos.push_back(info);
+      write.pImageInfo = &imageInfos.back();
+    }
+    writes.push_back(write);
+  }
+  vkUpdateDescriptorSets(mDevice, static_cast<uint32_t>(writes.size()),
+                         writes.data(), 0, nullptr);
+  Metrics::add(Counter::DESCRIPTOR_UPDATES, writes.size());
+  vkCmdBindDescriptorSets(cmdbuf, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          program.pipelineLayout, 0, 1, &set, 0, nullptr);
+}
+
+GpuFence VulkanDriver::dispatchCompute(ComputeDispatch const* dispatches,
+                                       size_t count) {
+  VkCommandBuffer cmdbuf = mCommands->get();
+  VkPipeline boundPipeline = VK_NULL_HANDLE;
+  for (size_t i = 0; i < count; ++i) {
+    ComputeDispatch const& dispatch = dispatches[i];
+    VulkanProgram* program = mPrograms.get(dispatch.program);
+    CHECK(program) << "Invalid program handle.";
+    CHECK(dispatch.pushConstantSize <= program->pushConstantSize)
+        << "Push constants of " << dispatch.pushConstantSize
+        << " bytes exceed the " << program->pushConstantSize
+        << "-byte block of the program.";
+
+    if (dispatch.barrier || mTransferPending) {
+      memoryBarrier(cmdbuf,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                        VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+      mTransferPending = false;
+    }
+
+    if (program->pipeline != boundPipeline) {
+      vkCmdBindPipeline(cmdbuf, VK_PIPELINE_BIND_POINT_COMPUTE,
+                        program->pipeline);
+      boundPipeline = program->pipeline;
+      Metrics::add(Counter::PIPELINE_BINDS);
+    }
+    bindDescriptors(cmdbuf, *program, dispatch);
+    if (program->pushConstantSize) {
+      // The whole declared block is pushed; bytes the dispatch did not set
+      // are zero.
+      vkCmdPushConstants(cmdbuf, program->pipelineLayout,
+                         VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                         program->pushConstantSize, dispatch.pushConstants);
+    }
+
+    if (dispatch.indirectBuffer) {
+      VulkanBufferObject* indirect =
+          mBufferObjects.get(dispatch.indirectBuffer);
+      CHECK(indirect) << "Invalid indirect buffer handle.";
+      vkCmdDispatchIndirect(cmdbuf, indirect->buffer, dispatch.indirectOffset);
+    } else {
+      vkCmdDispatch(cmdbuf, dispatch.groupCount[0], dispatch.groupCount[1],
+                    dispatch.groupCount[2]);
+    }
+  }
+  Metrics::add(Counter::DISPATCHES, count);
+
+  return flush();
+}
+
+GpuFence VulkanDriver::flush() {
+  GpuFence fence{mCommands->flush()};
+  mCommands->gc();
+  return fence;
+}
+
+VulkanReadback* VulkanDriver::allocateReadback(uint32_t byteCount,
+                                               uint64_t* id) {
+  if (!mReadbacks) {
+    mReadbacks = std::make_unique<VulkanReadbackRing>(
+        mDevice, *mAllocator, READBACK_RING_SIZE, READBACK_ALIGNMENT);
+  }
+  // A full ring is back-pressure for the caller, not an error.
+  VulkanReadback* readback = mReadbacks->allocate(byteCount, id);
+  if (!readback) {
+    return nullptr;
+  }
+  readback->value = mCommands->getRecordingValue();
+  return readback;
+}
+
+ReadbackHandle VulkanDriver::readBufferObjectAsync(BufferObjectHandle bo,
+                                                   uint32_t byteCount,
+                                                   uint32_t byteOffset) {
+  VulkanBufferObject* buffer = mBufferObjects.get(bo);
+  CHECK(buffer) << "Invalid buffer object handle.";
+  if (byteCount == 0 ||
+      uint64_t(byteOffset) + byteCount > buffer->byteCount) {
+    LOG(ERROR) << "Buffer readback out of range: offset=" << byteOffset
+               << " size=" << byteCount << " capacity=" << buffer->byteCount;
+    return {};
+  }
+
+  VkCommandBuffer cmdbuf = mCommands->get();
+  uint64_t id;
+  VulkanReadback* readback = allocateReadback(byteCount, &id);
+  if (!readback) {
+    return {};
+  }
+  memoryBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT);
+  VkBufferCopy region{byteOffset, readback->offset, byteCount};
+  vkCmdCopyBuffer(cmdbuf, buffer->buffer, mReadbacks->getBuffer(), 1,
+                  &region);
+  hostBarrier(cmdbuf);
+  return toReadbackHandle(id);
+}
+
+ReadbackHandle VulkanDriver::readTextureAsync(TextureHandle th,
+                                              uint8_t level) {
+  VulkanTexture* texture = mTextures.get(th);
+  CHECK(texture) << "Invalid texture handle.";
+  if (level >= texture->levels) {
+    LOG(ERROR) << "Texture readback of missing level " << uint32_t(level);
+    return {};
+  }
+  uint64_t const levelSize = vkutils::getLevelSize(
+      texture->format, texture->width, texture->height, level);
+  if (levelSize > UINT32_MAX) {
+    LOG(ERROR) << "Texture level too large to read back: " << levelSize;
+    return {};
+  }
+
+  VkCommandBuffer cmdbuf = mCommands->get();
+  uint64_t id;
+  VulkanReadback* readback =
+      allocateReadback(static_cast<uint32_t>(levelSize), &id);
+  if (!readback) {
+    return {};
+  }
+  uint32_t const width = std::max(texture->width >> level, 1u);
+  uint32_t const height = std::max(texture->height >> level, 1u);
+  uint32_t const dim = vkutils::getBlockDimension(texture->format);
+  readback->rowPitch =
+      (width + dim - 1) / dim * vkutils::getBlockSize(texture->format);
+
+  memoryBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT);
+  VkBufferImageCopy region{};
+  region.bufferOffset = readback->offset;
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+  region.imageExtent = {width, height, 1};
+  vkCmdCopyImageToBuffer(cmdbuf, texture->image, VK_IMAGE_LAYOUT_GENERAL,
+                         mReadbacks->getBuffer(), 1, &region);
+  hostBarrier(cmdbuf);
+  return toReadbackHandle(id);
+}
+
+bool VulkanDriver::isReadbackReady(ReadbackHandle rh) {
+  VulkanReadback const* readback =
+      mReadbacks && rh ? mReadbacks->get(toReadbackId(rh)) : nullptr;
+  return readback && readback->value <= mCommands->getCompletedValue();
+}
+
+ReadbackView VulkanDriver::getReadbackView(ReadbackHandle rh) {
+  if (!isReadbackReady(rh)) {
+    return {};
+  }
+  VulkanReadback* readback = mReadbacks->get(toReadbackId(rh));
+  if (!readback->invalidated) {
+    mAllocator->invalidate(mReadbacks->getAllocation(), readback->offset,
+                           readback->size);
+    readback->invalidated = true;
+  }
+  ReadbackView view;
+  view.data = mReadbacks->getData(*readback);
+  view.byteCount = readback->byteCount;
+  view.rowPitch = readback->rowPitch;
+  return view;
+}
+
+void VulkanDriver::releaseReadback(ReadbackHandle rh) {
+  if (mReadbacks && rh) {
+    mReadbacks->release(toReadbackId(rh));
+  }
+}
+
+MemoryBudget VulkanDriver::getMemoryBudget() {
+  VkPhysicalDeviceMemoryProperties const& properties =
+      mContext.getMemoryProperties();
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+  budgetProperties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  bool const supported = mContext.isMemoryBudgetSupported();
+  if (supported) {
+    VkPhysicalDeviceMemoryProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    properties2.pNext = &budgetProperties;
+    vkGetPhysicalDeviceMemoryProperties2(mPlatform->getPhysicalDevice(),
+                                         &properties2);
+  }
+
+  MemoryBudget budget;
+  for (uint32_t heap = 0; heap < properties.memoryHeapCount; ++heap) {
+    if (!(properties.memoryHeaps[heap].flags &
+          VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+      continue;
+    }
+    if (supported) {
+      budget.budget += budgetProperties.heapBudget[heap];
+      budget.usage += budgetProperties.heapUsage[heap];
+    } else {
+      budget.usage += mAllocator->getHeapUsage(heap);
+    }
+  }
+  return budget;
+}
+
+MemoryFragmentation VulkanDriver::getMemoryFragmentation() {
+  return mAllocator->getFragmentation();
+}
+
+void VulkanDriver::relocate(VkCommandBuffer cmdbuf,
+                            VulkanBufferObject& buffer) {
+  auto* moved = new VulkanBufferObject(mDevice, *mAllocator, mQueueFamilies,
+                                       buffer.byteCount, buffer.usage);
+  VkBufferCopy region{0, 0, buffer.byteCount};
+  vkCmdCopyBuffer(cmdbuf, buffer.buffer, moved->buffer, 1, &region);
+
+  // After the swap |moved| owns the old buffer and memory.
+  std::swap(buffer.buffer, moved->buffer);
+  std::swap(buffer.allocation, moved->allocation);
+  mCommands->defer([this, moved]() {
+    moved->destroy(mDevice, *mAllocator);
+    delete moved;
+  });
+}
+
+void VulkanDriver::relocate(VkCommandBuffer cmdbuf, VulkanTexture& texture) {
+  auto* moved =
+      new VulkanTexture(mDevice, *mAllocator, mQueueFamilies, texture.format,
+                        texture.width, texture.height, texture.levels,
+                        texture.usage);
+  initializeLayout(cmdbuf, *moved);
+  std::vector<VkImageCopy> regions(texture.levels);
+  for (uint8_t level = 0; level < texture.levels; ++level) {
+    VkImageCopy& region = regions[level];
+    region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+    region.dstSubresource = region.srcSubresource;
+    region.extent = {std::max(texture.width >> level, 1u),
+                     std::max(texture.height >> level, 1u), 1};
+  }
+  vkCmdCopyImage(cmdbuf, texture.image, VK_IMAGE_LAYOUT_GENERAL,
+                 moved->image, VK_IMAGE_LAYOUT_GENERAL,
+                 static_cast<uint32_t>(regions.size()), regions.data());
+
+  // After the swap |moved| owns the old image, views and memory.
+  std::swap(texture.image, moved->image);
+  std::swap(texture.allocation, moved->allocation);
+  std::swap(texture.view, moved->view);
+  std::swap(texture.levelViews, moved->levelViews);
+  mCommands->defer([this, moved]() {
+    moved->destroy(mDevice, *mAllocator);
+    delete moved;
+  });
+}
+
+DefragmentationStats VulkanDriver::defragment(uint64_t maxBytes) {
+  mAllocator->selectEvacuationBlocks(DEFRAGMENT_MAX_OCCUPANCY);
+
+  // Descriptor sets are written for every dispatch, so nothing but the
+  // objects themselves refers to the memory being moved. Work recorded
+  // earlier keeps the old objects alive until it completes.
+  DefragmentationStats stats;
+  VkCommandBuffer cmdbuf = VK_NULL_HANDLE;
+  auto begin = [&](VulkanAllocation const& allocation,
+                   VkMemoryRequirements const& requirements) {
+    if (stats.resourcesMoved && stats.bytesMoved + allocation.size > maxBytes) {
+      return false;
+    }
+    if (!mAllocator->hasRoom(requirements, allocation.memoryType)) {
+      // Moving would only grow another block. Give up on this one; it sits
+      // out the next calls so that other blocks are picked meanwhile.
+      mAllocator->cancelEvacuation(allocation.block);
+      return false;
+    }
+    if (!cmdbuf) {
+      cmdbuf = mCommands->get();
+      memoryBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_READ_BIT);
+    }
+    stats.bytesMoved += allocation.size;
+    stats.resourcesMoved++;
+    return true;
+  };
+
+  mBufferObjects.forEach([&](VulkanBufferObject& buffer) {
+    if (!buffer.allocation.block || !buffer.allocation.block->evacuating) {
+      return;
+    }
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(mDevice, buffer.buffer, &requirements);
+    if (begin(buffer.allocation, requirements)) {
+      relocate(cmdbuf, buffer);
+    }
+  });
+  mTextures.forEach([&](VulkanTexture& texture) {
+    if (!texture.allocation.block || !texture.allocation.block->evacuating) {
+      return;
+    }
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(mDevice, texture.image, &requirements);
+    if (begin(texture.allocation, requirements)) {
+      relocate(cmdbuf, texture);
+    }
+  });
+
+  if (stats.resourcesMoved) {
+    mTransferPending = true;
+  }
+  stats.blocksEvacuating = mAllocator->getEvacuatingBlockCount();
+  return stats;
+}
+
+bool VulkanDriver::isSignaled(GpuFence fence) {
+  return fence.value <= mCommands->getCompletedValue();
+}
+
+bool VulkanDriver::wait(GpuFence fence, uint64_t timeoutNs) {
+  bool const signaled = mCommands->wait(fence.value, timeoutNs);
+  if (signaled) {
+    mCommands->gc();
+  }
+  return signaled;
+}
+
 }  // namespace engine::backend
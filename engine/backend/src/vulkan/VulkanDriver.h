@@ -1,7 +1,13 @@
 #pragma once
 
+#include <memory>
+
 #include "DriverBase.h"
+#include "VulkanCommands.h"
 #include "VulkanContext.h"
+#include "VulkanHandles.h"
+#include "VulkanMemory.h"
+#include "VulkanReadback.h"
 #include "private/backend/Driver.h"
 
 namespace engine::backend {
@@ -43,13 +49,107 @@ class VulkanDriver final : public DriverBase {
 
   void terminate() override;
 
+  BufferObjectHandle createBufferObject(uint32_t byteCount,
+                                        BufferUsage usage) override;
+
+  void updateBufferObject(BufferObjectHandle bo, void const* data,
+                          uint32_t byteCount, uint32_t byteOffset) override;
+
+  void readBufferObject(BufferObjectHandle bo, void* data, uint32_t byteCount,
+                        uint32_t byteOffset) override;
+
+  void destroyBufferObject(BufferObjectHandle bo) override;
+
+  TextureHandle createTexture(TextureFormat format, uint32_t width,
+                              uint32_t height, uint8_t levels,
+                              TextureUsage usage) override;
+
+  void updateTexture(TextureHandle th, uint8_t level, void const* data,
+                     size_t byteCount) override;
+
+  void copyTexture(TextureHandle dst, uint8_t dstLevel, TextureHandle src,
+                   uint8_t srcLevel) override;
+
+  void destroyTexture(TextureHandle th) override;
+
+  ProgramHandle createComputeProgram(ComputeProgramDesc const& desc) override;
+
+  void destroyProgram(ProgramHandle ph) override;
+
+  GpuFence dispatchCompute(ComputeDispatch const* dispatches,
+                           size_t count) override;
+
+  GpuFence flush() override;
+
+  ReadbackHandle readBufferObjectAsync(BufferObjectHandle bo,
+                                       uint32_t byteCount,
+                                       uint32_t byteOffset) override;
+
+  ReadbackHandle readTextureAsync(TextureHandle th, uint8_t level) override;
+
+  bool isReadbackReady(ReadbackHandle rh) override;
+
+  ReadbackView getReadbackView(ReadbackHandle rh) override;
+
+  void releaseReadback(ReadbackHandle rh) override;
+
+  MemoryBudget getMemoryBudget() override;
+
+  MemoryFragmentation getMemoryFragmentation() override;
+
+  DefragmentationStats defragment(uint64_t maxBytes) override;
+
+  bool isSignaled(GpuFence fence) override;
+
+  bool wait(GpuFence fence, uint64_t timeoutNs) override;
+
   VulkanDriver(VulkanDriver const&) = delete;
   VulkanDriver& operator=(VulkanDriver const&) = delete;
 
  private:
+  // Makes all shader and transfer writes recorded so far visible to the
+  // commands that follow.
+  void memoryBarrier(VkCommandBuffer cmdbuf, VkPipelineStageFlags dstStage,
+                     VkAccessFlags dstAccess) noexcept;
+
+  // Reserves ring space for a readback that the caller records a copy into.
+  VulkanReadback* allocateReadback(uint32_t byteCount, uint64_t* id);
+
+  // Makes the transfer writes of readbacks visible to the host.
+  void hostBarrier(VkCommandBuffer cmdbuf) noexcept;
+
+  void bindDescriptors(VkCommandBuffer cmdbuf, VulkanProgram const& program,
+                       ComputeDispatch const& dispatch);
+
+  // Moves a new image from the undefined layout to GENERAL.
+  void initializeLayout(VkCommandBuffer cmdbuf,
+                        VulkanTexture const& texture) noexcept;
+
+  // Recreates the object in memory picked by the allocator and records a
+  // copy of its contents. The object itself, and so its handle, stays the
+  // same; its old Vulkan objects are destroyed once the GPU is done.
+  void relocate(VkCommandBuffer cmdbuf, VulkanBufferObject& buffer);
+  void relocate(VkCommandBuffer cmdbuf, VulkanTexture& texture);
+
   VulkanPlatform* mPlatform;
 
   VulkanContext mContext;
+
+  VkDevice const mDevice;
+  VulkanQueueFamilies mQueueFamilies;
+  std::unique_ptr<VulkanAllocator> mAllocator;
+  std::unique_ptr<VulkanCommands> mCommands;
+  VkSampler mSampler = VK_NULL_HANDLE;
+
+  VulkanResourceTable<VulkanBufferObject, HwBufferObject> mBufferObjects;
+  VulkanResourceTable<VulkanTexture, HwTexture> mTextures;
+  VulkanResourceTable<VulkanProgram, HwProgram> mPrograms;
+  // Created on the first asynchronous readback.
+  std::unique_ptr<VulkanReadbackRing> mReadbacks;
+
+  // Set when transfers were recorded after the last barrier, so the next
+  // dispatch must wait for them even if it asked for no barrier.
+  bool mTransferPending = false;
 };
 
 }  // namespace engine::backend
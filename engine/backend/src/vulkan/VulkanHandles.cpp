@@ -0,0 +1,212 @@
+#include "VulkanHandles.h"
+
+#include "absl/log/check.h"
+#include "vulkan/utils/Conversion.h"
+
+namespace engine::backend {
+
+VulkanBufferObject::VulkanBufferObject(VkDevice device,
+                                       VulkanAllocator& allocator,
+                                       VulkanQueueFamilies const& families,
+                                       uint32_t byteCount, BufferUsage usage)
+    : byteCount(byteCount), usage(usage) {
+  VkBufferCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  createInfo.size = byteCount;
+  createInfo.usage = vkutils::getVkBufferUsage(usage);
+  if (families.count > 1) {
+    createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    createInfo.queueFamilyIndexCount = families.count;
+    createInfo.pQueueFamilyIndices = families.indices;
+  }
+  VkResult result = vkCreateBuffer(device, &createInfo, nullptr, &buffer);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateBuffer error=" << static_cast<int32_t>(result);
+
+  VkMemoryRequirements requirements;
+  vkGetBufferMemoryRequirements(device, buffer, &requirements);
+  allocation = allocator.allocate(requirements, 0,
+                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  result = vkBindBufferMemory(device, buffer, allocation.memory,
+                              allocation.offset);
+  CHECK(result == VK_SUCCESS)
+      << "vkBindBufferMemory error=" << static_cast<int32_t>(result);
+}
+
+void VulkanBufferObject::destroy(VkDevice device,
+                                 VulkanAllocator& allocator) noexcept {
+  vkDestroyBuffer(device, buffer, nullptr);
+  allocator.free(allocation);
+  buffer = VK_NULL_HANDLE;
+}
+
+VulkanTexture::VulkanTexture(VkDevice device, VulkanAllocator& allocator,
+                             VulkanQueueFamilies const& families,
+                             TextureFormat format, uint32_t width,
+                             uint32_t height, uint8_t levels,
+                             TextureUsage usage)
+    : vkFormat(vkutils::getVkFormat(format)),
+      format(format),
+      width(width),
+      height(height),
+      levels(levels),
+      usage(usage) {
+  VkImageCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  createInfo.imageType = VK_IMAGE_TYPE_2D;
+  createInfo.format = vkFormat;
+  createInfo.extent = {width, height, 1};
+  createInfo.mipLevels = levels;
+  createInfo.arrayLayers = 1;
+  createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  createInfo.usage = vkutils::getVkImageUsage(usage);
+  createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  if (families.count > 1) {
+    createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    createInfo.queueFamilyIndexCount = families.count;
+    createInfo.pQueueFamilyIndices = families.indices;
+  }
+  VkResult result = vkCreateImage(device, &createInfo, nullptr, &image);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateImage error=" << static_cast<int32_t>(result);
+
+  VkMemoryRequirements requirements;
+  vkGetImageMemoryRequirements(device, image, &requirements);
+  allocation = allocator.allocate(requirements, 0,
+                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  result =
+      vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+  CHECK(result == VK_SUCCESS)
+      << "vkBindImageMemory error=" << static_cast<int32_t>(result);
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = vkFormat;
+  viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1};
+  result = vkCreateImageView(device, &viewInfo, nullptr, &view);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateImageView error=" << static_cast<int32_t>(result);
+
+  if (any(usage, TextureUsage::STORAGE)) {
+    levelViews.resize(levels);
+    for (uint8_t level = 0; level < levels; ++level) {
+      viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+      result =
+          vkCreateImageView(device, &viewInfo, nullptr, &levelViews[level]);
+      CHECK(result == VK_SUCCESS)
+          << "vkCreateImageView error=" << static_cast<int32_t>(result);
+    }
+  }
+}
+
+void VulkanTexture::destroy(VkDevice device,
+                            VulkanAllocator& allocator) noexcept {
+  for (VkImageView levelView : levelViews) {
+    vkDestroyImageView(device, levelView, nullptr);
+  }
+  levelViews.clear();
+  vkDestroyImageView(device, view, nullptr);
+  vkDestroyImage(device, image, nullptr);
+  allocator.free(allocation);
+  image = VK_NULL_HANDLE;
+}
+
+VulkanStage::VulkanStage(VkDevice device, VulkanAllocator& allocator,
+                         VkDeviceSize byteCount, bool readback)
+    : byteCount(byteCount) {
+  VkBufferCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  createInfo.size = byteCount;
+  createInfo.usage = readback ? VK_BUFFER_USAGE_TRANSFER_DST_BIT
+                              : VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  VkResult result = vkCreateBuffer(device, &createInfo, nullptr, &buffer);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateBuffer error=" << static_cast<int32_t>(result);
+
+  VkMemoryRequirements requirements;
+  vkGetBufferMemoryRequirements(device, buffer, &requirements);
+  allocation = allocator.allocate(
+      requirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+      readback ? VK_MEMORY_PROPERTY_HOST_CACHED_BIT
+               : VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  result = vkBindBufferMemory(device, buffer, allocation.memory,
+                              allocation.offset);
+  CHECK(result == VK_SUCCESS)
+      << "vkBindBufferMemory error=" << static_cast<int32_t>(result);
+}
+
+void VulkanStage::destroy(VkDevice device,
+                          VulkanAllocator& allocator) noexcept {
+  vkDestroyBuffer(device, buffer, nullptr);
+  allocator.free(allocation);
+  buffer = VK_NULL_HANDLE;
+}
+
+VulkanProgram::VulkanProgram(VkDevice device, ComputeProgramDesc const& desc)
+    : bindings(desc.bindings), pushConstantSize(desc.pushConstantSize) {
+  VkShaderModuleCreateInfo moduleInfo{};
+  moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  moduleInfo.codeSize = desc.spirvSize;
+  moduleInfo.pCode = desc.spirv;
+  VkResult result =
+      vkCreateShaderModule(device, &moduleInfo, nullptr, &module);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateShaderModule error=" << static_cast<int32_t>(result);
+
+  std::vector<VkDescriptorSetLayoutBinding> layoutBindings(bindings.size());
+  for (uint32_t i = 0; i < bindings.size(); ++i) {
+    layoutBindings[i].binding = i;
+    layoutBindings[i].descriptorType =
+        vkutils::getVkDescriptorType(bindings[i]);
+    layoutBindings[i].descriptorCount = 1;
+    layoutBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+  layoutInfo.pBindings = layoutBindings.data();
+  result = vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr,
+                                       &descriptorSetLayout);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateDescriptorSetLayout error=" << static_cast<int32_t>(result);
+
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstantRange.size = pushConstantSize;
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount = 1;
+  pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+  pipelineLayoutInfo.pushConstantRangeCount = pushConstantSize ? 1 : 0;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+  result = vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr,
+                                  &pipelineLayout);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreatePipelineLayout error=" << static_cast<int32_t>(result);
+
+  VkComputePipelineCreateInfo pipelineInfo{};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipelineInfo.stage.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipelineInfo.stage.module = module;
+  pipelineInfo.stage.pName = desc.entryPoint;
+  pipelineInfo.layout = pipelineLayout;
+  result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo,
+                                    nullptr, &pipeline);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateComputePipelines error=" << static_cast<int32_t>(result);
+}
+
+void VulkanProgram::destroy(VkDevice device) noexcept {
+  vkDestroyPipeline(device, pipeline, nullptr);
+  vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+  vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+  vkDestroyShaderModule(device, module, nullptr);
+  pipeline = VK_NULL_HANDLE;
+}
+
+}  // namespace engine::backend
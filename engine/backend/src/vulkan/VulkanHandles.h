@@ -0,0 +1,152 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "VulkanMemory.h"
+#include "private/backend/DriverEnums.h"
+#include "private/backend/Handle.h"
+#include "volk.h"
+
+namespace engine::backend {
+
+// Queue families that share ownership of every resource.
+struct VulkanQueueFamilies {
+  uint32_t indices[2];
+  uint32_t count;
+};
+
+struct VulkanBufferObject {
+  VulkanBufferObject(VkDevice device, VulkanAllocator& allocator,
+                     VulkanQueueFamilies const& families, uint32_t byteCount,
+                     BufferUsage usage);
+
+  void destroy(VkDevice device, VulkanAllocator& allocator) noexcept;
+
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VulkanAllocation allocation;
+  uint32_t const byteCount;
+  BufferUsage const usage;
+};
+
+// Images live in VK_IMAGE_LAYOUT_GENERAL for their whole lifetime, which is
+// valid for storage, sampling and transfers alike.
+struct VulkanTexture {
+  VulkanTexture(VkDevice device, VulkanAllocator& allocator,
+                VulkanQueueFamilies const& families, TextureFormat format,
+                uint32_t width, uint32_t height, uint8_t levels,
+                TextureUsage usage);
+
+  void destroy(VkDevice device, VulkanAllocator& allocator) noexcept;
+
+  VkImage image = VK_NULL_HANDLE;
+  VulkanAllocation allocation;
+  VkFormat vkFormat;
+  TextureFormat const format;
+  uint32_t const width;
+  uint32_t const height;
+  uint8_t const levels;
+  TextureUsage const usage;
+  // View of the whole mip chain, used for sampling.
+  VkImageView view = VK_NULL_HANDLE;
+  // One view per mip level, used for storage image binding.
+  std::vector<VkImageView> levelViews;
+};
+
+// Host-visible buffer used as the source of uploads or the destination of
+// readbacks. Readback stages prefer cached memory for fast CPU reads.
+struct VulkanStage {
+  VulkanStage(VkDevice device, VulkanAllocator& allocator,
+              VkDeviceSize byteCount, bool readback);
+
+  void destroy(VkDevice device, VulkanAllocator& allocator) noexcept;
+
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VulkanAllocation allocation;
+  VkDeviceSize const byteCount;
+};
+
+struct VulkanProgram {
+  VulkanProgram(VkDevice device, ComputeProgramDesc const& desc);
+
+  void destroy(VkDevice device) noexcept;
+
+  VkShaderModule module = VK_NULL_HANDLE;
+  VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+  VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  std::vector<DescriptorType> const bindings;
+  uint32_t const pushConstantSize;
+};
+
+// Maps handles to driver objects. Ids of destroyed objects are reused; each
+// slot counts its removals so that a handle to a previous occupant no longer
+// resolves.
+template <typename T, typename HwT>
+class VulkanResourceTable {
+ public:
+  using HandleType = Handle<HwT>;
+
+  HandleType insert(std::unique_ptr<T> object) {
+    if (!mFreeIds.empty()) {
+      uint32_t const id = mFreeIds.back();
+      mFreeIds.pop_back();
+      mSlots[id].object = std::move(object);
+      return HandleType(id, mSlots[id].generation);
+    }
+    mSlots.push_back({std::move(object), 0});
+    return HandleType(static_cast<uint32_t>(mSlots.size() - 1), 0);
+  }
+
+  // Returns null for handles that are out of range, already removed or
+  // refer to a previous occupant of their slot.
+  T* get(HandleType handle) const noexcept {
+    return contains(handle) ? mSlots[handle.getId()].object.get() : nullptr;
+  }
+
+  // Returns null, and leaves the free list alone, for the same handles as
+  // get().
+  std::unique_ptr<T> remove(HandleType handle) {
+    if (!contains(handle)) {
+      return nullptr;
+    }
+    Slot& slot = mSlots[handle.getId()];
+    std::unique_ptr<T> object = std::move(slot.object);
+    slot.generation++;
+    mFreeIds.push_back(handle.getId());
+    return object;
+  }
+
+  template <typename F>
+  void forEach(F&& f) {
+    for (auto& slot : mSlots) {
+      if (slot.object) {
+        f(*slot.object);
+      }
+    }
+  }
+
+  void clear() {
+    mSlots.clear();
+    mFreeIds.clear();
+  }
+
+ private:
+  struct Slot {
+    std::unique_ptr<T> object;
+    uint32_t generation;
+  };
+
+  bool contains(HandleType handle) const noexcept {
+    uint32_t const id = handle.getId();
+    return id < mSlots.size() && mSlots[id].object &&
+           mSlots[id].generation == handle.getGeneration();
+  }
+
+  std::vector<Slot> mSlots;
+  std::vector<uint32_t> mFreeIds;
+};
+
+}  // namespace engine::backend
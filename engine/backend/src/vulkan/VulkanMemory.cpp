@@ -0,0 +1,393 @@
+#include "VulkanMemory.h"
+
+#include <assert.h>
+
+#include <algorithm>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "metrics/Metrics.h"
+
+namespace engine::backend {
+
+using metrics::Counter;
+using metrics::Metrics;
+
+namespace {
+
+constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+// Calls to selectEvacuationBlocks(), one per defragment(), that a block sits
+// out after its evacuation was cancelled. The rest of memory changes in the meantime, so it may fit
+// elsewhere by then.
+constexpr uint32_t EVACUATION_COOLDOWN = 64;
+
+inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+inline VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment) {
+  return value / alignment * alignment;
+}
+
+inline uint32_t countBits(VkMemoryPropertyFlags flags) {
+  uint32_t count = 0;
+  for (; flags; flags &= flags - 1) {
+    count++;
+  }
+  return count;
+}
+
+}  // anonymous namespace
+
+VulkanAllocator::VulkanAllocator(VkDevice device,
+                                 VulkanContext const& context) noexcept
+    : mDevice(device),
+      mMemoryProperties(context.getMemoryProperties()),
+      mBufferImageGranularity(context.getPhysicalDeviceProperties()
+                                  .limits.bufferImageGranularity),
+      mNonCoherentAtomSize(
+          context.getPhysicalDeviceProperties().limits.nonCoherentAtomSize) {}
+
+VulkanAllocator::~VulkanAllocator() noexcept {
+  for (auto& blocks : mBlocks) {
+    for (auto& block : blocks) {
+      if (block->used) {
+        LOG(WARNING) << "Leaked " << block->used << " bytes of memory type "
+                     << block->memoryType;
+      }
+      if (block->mapped) {
+        vkUnmapMemory(mDevice, block->memory);
+      }
+      vkFreeMemory(mDevice, block->memory, nullptr);
+    }
+    blocks.clear();
+  }
+}
+
+int32_t VulkanAllocator::findMemoryType(
+    uint32_t typeBits, VkMemoryPropertyFlags required,
+    VkMemoryPropertyFlags preferred) const noexcept {
+  int32_t best = -1;
+  uint32_t bestScore = 0;
+  for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i) {
+    VkMemoryPropertyFlags const flags =
+        mMemoryProperties.memoryTypes[i].propertyFlags;
+    if (!(typeBits & (1u << i)) || (flags & required) != required) {
+      continue;
+    }
+    uint32_t const score = countBits(flags & preferred) + 1;
+    if (score > bestScore) {
+      best = static_cast<int32_t>(i);
+      bestScore = score;
+    }
+  }
+  return best;
+}
+
+VulkanMemoryBlock* VulkanAllocator::findRange(
+    uint32_t memoryType, VkDeviceSize size, VkDeviceSize alignment,
+    VkDeviceSize* offset) const noexcept {
+  VulkanMemoryBlock* block = nullptr;
+  VkDeviceSize bestWaste = ~VkDeviceSize(0);
+  for (auto const& candidate : mBlocks[memoryType]) {
+    if (candidate->dedicated || candidate->evacuating ||
+        candidate->size - candidate->used < size) {
+      continue;
+    }
+    for (auto const& [rangeOffset, rangeSize] : candidate->freeRanges) {
+      VkDeviceSize const aligned = alignUp(rangeOffset, alignment);
+      if (aligned + size > rangeOffset + rangeSize) {
+        continue;
+      }
+      VkDeviceSize const waste = rangeSize - size;
+      if (waste < bestWaste) {
+        bestWaste = waste;
+        block = candidate.get();
+        *offset = aligned;
+      }
+    }
+  }
+  return block;
+}
+
+VulkanMemoryBlock* VulkanAllocator::createBlock(uint32_t memoryType,
+                                                VkDeviceSize size) {
+  auto block = std::make_unique<VulkanMemoryBlock>();
+  block->size = size;
+  block->memoryType = memoryType;
+
+  VkMemoryAllocateInfo allocateInfo{};
+  allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocateInfo.allocationSize = size;
+  allocateInfo.memoryTypeIndex = memoryType;
+  VkResult result =
+      vkAllocateMemory(mDevice, &allocateInfo, nullptr, &block->memory);
+  CHECK(result == VK_SUCCESS)
+      << "vkAllocateMemory failed. size=" << size << " type=" << memoryType
+      << " error=" << static_cast<int32_t>(result);
+
+  if (getMemoryTypeProperties(memoryType) &
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    result = vkMapMemory(mDevice, block->memory, 0, VK_WHOLE_SIZE, 0,
+                         &block->mapped);
+    CHECK(result == VK_SUCCESS)
+        << "vkMapMemory error=" << static_cast<int32_t>(result);
+  }
+
+  block->freeRanges.emplace(0, size);
+  mBlocks[memoryType].push_back(std::move(block));
+  return mBlocks[memoryType].back().get();
+}
+
+void VulkanAllocator::destroyBlock(VulkanMemoryBlock* block) noexcept {
+  auto& blocks = mBlocks[block->memoryType];
+  auto it = std::find_if(blocks.begin(), blocks.end(),
+                         [block](auto const& b) { return b.get() == block; });
+  assert(it != blocks.end());
+  if (block->mapped) {
+    vkUnmapMemory(mDevice, block->memory);
+  }
+  vkFreeMemory(mDevice, block->memory, nullptr);
+  blocks.erase(it);
+}
+
+VulkanAllocation VulkanAllocator::allocate(
+    VkMemoryRequirements const& requirements, VkMemoryPropertyFlags required,
+    VkMemoryPropertyFlags preferred) {
+  int32_t const type =
+      findMemoryType(requirements.memoryTypeBits, required, preferred);
+  CHECK(type >= 0) << "No memory type with properties " << required;
+  uint32_t const memoryType = static_cast<uint32_t>(type);
+
+  // Buffers and images share blocks, so keep every allocation on its own
+  // bufferImageGranularity page.
+  VkDeviceSize const alignment =
+      std::max(requirements.alignment, mBufferImageGranularity);
+  VkDeviceSize const size = alignUp(requirements.size, alignment);
+
+  uint32_t const heap = mMemoryProperties.memoryTypes[memoryType].heapIndex;
+  VkDeviceSize const blockSize = std::min(
+      DEFAULT_BLOCK_SIZE, mMemoryProperties.memoryHeaps[heap].size / 8);
+
+  VulkanMemoryBlock* block = nullptr;
+  VkDeviceSize offset = 0;
+  if (size > blockSize / 2) {
+    block = createBlock(memoryType, size);
+    block->dedicated = true;
+  } else {
+    block = findRange(memoryType, size, alignment, &offset);
+    if (!block) {
+      block = createBlock(memoryType, blockSize);
+      offset = 0;
+    }
+  }
+
+  // Carve [offset, offset + size) out of the free range that contains it.
+  auto it = std::prev(block->freeRanges.upper_bound(offset));
+  VkDeviceSize const rangeOffset = it->first;
+  VkDeviceSize const rangeEnd = it->first + it->second;
+  block->freeRanges.erase(it);
+  if (offset > rangeOffset) {
+    block->freeRanges.emplace(rangeOffset, offset - rangeOffset);
+  }
+  if (offset + size < rangeEnd) {
+    block->freeRanges.emplace(offset + size, rangeEnd - offset - size);
+  }
+  block->used += size;
+  Metrics::add(Counter::ALLOCATIONS);
+  Metrics::add(Counter::BYTES_ALLOCATED, size);
+
+  VulkanAllocation allocation;
+  allocation.memory = block->memory;
+  allocation.offset = offset;
+  allocation.size = size;
+  allocation.mapped =
+      block->mapped ? static_cast<uint8_t*>(block->mapped) + offset : nullptr;
+  allocation.memoryType = memoryType;
+  allocation.block = block;
+  return allocation;
+}
+
+void VulkanAllocator::free(VulkanAllocation& allocation) noexcept {
+  VulkanMemoryBlock* block = allocation.block;
+  if (!block) {
+    return;
+  }
+  block->used -= allocation.size;
+  if (block->used == 0 &&
+      (block->dedicated || mBlocks[block->memoryType].size() > 1)) {
+    // Keep one empty block per memory type around to avoid churn.
+    destroyBlock(block);
+    allocation = {};
+    return;
+  }
+  if (block->used == 0) {
+    block->evacuating = false;
+  }
+
+  VkDeviceSize offset = allocation.offset;
+  VkDeviceSize size = allocation.size;
+  auto next = block->freeRanges.lower_bound(offset);
+  if (next != block->freeRanges.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      size += prev->second;
+      block->freeRanges.erase(prev);
+    }
+  }
+  if (next != block->freeRanges.end() && offset + size == next->first) {
+    size += next->second;
+    block->freeRanges.erase(next);
+  }
+  block->freeRanges.emplace(offset, size);
+  allocation = {};
+}
+
+VkMemoryPropertyFlags VulkanAllocator::getMemoryTypeProperties(
+    uint32_t memoryType) const noexcept {
+  return mMemoryProperties.memoryTypes[memoryType].propertyFlags;
+}
+
+VkDeviceSize VulkanAllocator::getHeapUsage(uint32_t heap) const noexcept {
+  VkDeviceSize usage = 0;
+  for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i) {
+    if (mMemoryProperties.memoryTypes[i].heapIndex != heap) {
+      continue;
+    }
+    for (auto const& block : mBlocks[i]) {
+      usage += block->size;
+    }
+  }
+  return usage;
+}
+
+MemoryFragmentation VulkanAllocator::getFragmentation() const noexcept {
+  MemoryFragmentation stats;
+  for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i) {
+    if (!(getMemoryTypeProperties(i) & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+      continue;
+    }
+    for (auto const& block : mBlocks[i]) {
+      if (block->dedicated) {
+        continue;
+      }
+      stats.blockBytes += block->size;
+      stats.usedBytes += block->used;
+      stats.blockCount++;
+      for (auto const& range : block->freeRanges) {
+        stats.largestFreeRange =
+            std::max<uint64_t>(stats.largestFreeRange, range.second);
+      }
+    }
+  }
+  uint64_t const freeBytes = stats.blockBytes - stats.usedBytes;
+  if (freeBytes) {
+    stats.fragmentation =
+        1.0f - float(double(stats.largestFreeRange) / double(freeBytes));
+  }
+  return stats;
+}
+
+void VulkanAllocator::selectEvacuationBlocks(float maxOccupancy) noexcept {
+  for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i) {
+    VkDeviceSize freeBytes = 0;
+    bool evacuating = false;
+    for (auto const& block : mBlocks[i]) {
+      // Counts down on every call, whether or not a block is picked below.
+      if (block->evacuationCooldown) {
+        block->evacuationCooldown--;
+      }
+      if (!block->dedicated) {
+        freeBytes += block->size - block->used;
+        evacuating |= block->evacuating;
+      }
+    }
+    if (evacuating) {
+      continue;
+    }
+    VulkanMemoryBlock* sparsest = nullptr;
+    for (auto const& block : mBlocks[i]) {
+      if (block->dedicated || block->evacuationCooldown || block->used == 0 ||
+          block->used > VkDeviceSize(maxOccupancy * block->size) ||
+          freeBytes - (block->size - block->used) < block->used) {
+        continue;
+      }
+      if (!sparsest ||
+          double(block->used) / block->size <
+              double(sparsest->used) / sparsest->size) {
+        sparsest = block.get();
+      }
+    }
+    if (sparsest) {
+      sparsest->evacuating = true;
+    }
+  }
+}
+
+void VulkanAllocator::cancelEvacuation(VulkanMemoryBlock* block) noexcept {
+  block->evacuating = false;
+  block->evacuationCooldown = EVACUATION_COOLDOWN;
+}
+
+uint32_t VulkanAllocator::getEvacuatingBlockCount() const noexcept {
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i) {
+    for (auto const& block : mBlocks[i]) {
+      count += block->evacuating ? 1 : 0;
+    }
+  }
+  return count;
+}
+
+bool VulkanAllocator::hasRoom(VkMemoryRequirements const& requirements,
+                              uint32_t memoryType) const noexcept {
+  VkDeviceSize const alignment =
+      std::max(requirements.alignment, mBufferImageGranularity);
+  VkDeviceSize const size = alignUp(requirements.size, alignment);
+  VkDeviceSize offset;
+  return findRange(memoryType, size, alignment, &offset) != nullptr;
+}
+
+VkMappedMemoryRange VulkanAllocator::getMappedRange(
+    VulkanAllocation const& allocation, VkDeviceSize offset,
+    VkDeviceSize size) const noexcept {
+  // Ranges must be aligned to nonCoherentAtomSize, relative to the memory
+  // object, and stay within the block.
+  VkDeviceSize const begin =
+      alignDown(allocation.offset + offset, mNonCoherentAtomSize);
+  VkDeviceSize const end =
+      std::min(alignUp(allocation.offset + offset + size, mNonCoherentAtomSize),
+               allocation.block->size);
+  VkMappedMemoryRange range{};
+  range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+  range.memory = allocation.memory;
+  range.offset = begin;
+  range.size = end - begin;
+  return range;
+}
+
+void VulkanAllocator::flush(VulkanAllocation const& allocation,
+                            VkDeviceSize offset,
+                            VkDeviceSize size) const noexcept {
+  if (getMemoryTypeProperties(allocation.memoryType) &
+      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+    return;
+  }
+  VkMappedMemoryRange const range = getMappedRange(allocation, offset, size);
+  vkFlushMappedMemoryRanges(mDevice, 1, &range);
+}
+
+void VulkanAllocator::invalidate(VulkanAllocation const& allocation,
+                                 VkDeviceSize offset,
+                                 VkDeviceSize size) const noexcept {
+  if (getMemoryTypeProperties(allocation.memoryType) &
+      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+    return;
+  }
+  VkMappedMemoryRange const range = getMappedRange(allocation, offset, size);
+  vkInvalidateMappedMemoryRanges(mDevice, 1, &range);
+}
+
+}  // namespace engine::backend
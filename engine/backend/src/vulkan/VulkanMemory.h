@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "VulkanContext.h"
+#include "private/backend/DriverEnums.h"
+#include "volk.h"
+
+namespace engine::backend {
+
+struct VulkanMemoryBlock;
+
+struct VulkanAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  // Persistently mapped pointer to the allocation, or nullptr when the
+  // memory is not host visible.
+  void* mapped = nullptr;
+  uint32_t memoryType = 0;
+  VulkanMemoryBlock* block = nullptr;
+};
+
+// Sub-allocates buffers and images from large VkDeviceMemory blocks, one
+// list of blocks per memory type. Host-visible blocks stay mapped for their
+// whole lifetime.
+class VulkanAllocator {
+ public:
+  VulkanAllocator(VkDevice device, VulkanContext const& context) noexcept;
+  ~VulkanAllocator() noexcept;
+
+  VulkanAllocator(VulkanAllocator const&) = delete;
+  VulkanAllocator& operator=(VulkanAllocator const&) = delete;
+
+  // Picks the first memory type that has all |required| and as many
+  // |preferred| properties as possible.
+  VulkanAllocation allocate(VkMemoryRequirements const& requirements,
+                            VkMemoryPropertyFlags required,
+                            VkMemoryPropertyFlags preferred = 0);
+
+  void free(VulkanAllocation& allocation) noexcept;
+
+  // Makes host writes visible to the device for non-coherent memory.
+  void flush(VulkanAllocation const& allocation, VkDeviceSize offset,
+             VkDeviceSize size) const noexcept;
+
+  // Makes device writes visible to the host for non-coherent memory.
+  void invalidate(VulkanAllocation const& allocation, VkDeviceSize offset,
+                  VkDeviceSize size) const noexcept;
+
+  VkMemoryPropertyFlags getMemoryTypeProperties(
+      uint32_t memoryType) const noexcept;
+
+  // Bytes of VkDeviceMemory this allocator holds in |heap|, including the
+  // unused parts of its blocks.
+  VkDeviceSize getHeapUsage(uint32_t heap) const noexcept;
+
+  MemoryFragmentation getFragmentation() const noexcept;
+
+  // For every memory type without a block being evacuated, picks the
+  // sparsest shared block that is at most |maxOccupancy| full and whose
+  // live bytes fit in the free space of the other blocks. New allocations
+  // avoid evacuating blocks, which are released once their last allocation
+  // is freed. Blocks whose evacuation was cancelled are passed over for a
+  // number of calls.
+  void selectEvacuationBlocks(float maxOccupancy) noexcept;
+
+  // Lets new allocations use |block| again, and keeps it from being
+  // selected for a while so that other blocks get compacted.
+  void cancelEvacuation(VulkanMemoryBlock* block) noexcept;
+
+  uint32_t getEvacuatingBlockCount() const noexcept;
+
+  // Whether an allocation with |requirements| fits in an existing block of
+  // |memoryType| that is not being evacuated.
+  bool hasRoom(VkMemoryRequirements const& requirements,
+               uint32_t memoryType) const noexcept;
+
+ private:
+  int32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required,
+                         VkMemoryPropertyFlags preferred) const noexcept;
+
+  // Best fit over the shared blocks of |memoryType| that are not being
+  // evacuated. Returns nullptr if none has room.
+  VulkanMemoryBlock* findRange(uint32_t memoryType, VkDeviceSize size,
+                               VkDeviceSize alignment,
+                               VkDeviceSize* offset) const noexcept;
+
+  VulkanMemoryBlock* createBlock(uint32_t memoryType, VkDeviceSize size);
+
+  void destroyBlock(VulkanMemoryBlock* block) noexcept;
+
+  VkMappedMemoryRange getMappedRange(VulkanAllocation const& allocation,
+                                     VkDeviceSize offset,
+                                     VkDeviceSize size) const noexcept;
+
+  VkDevice const mDevice;
+  VkPhysicalDeviceMemoryProperties const mMemoryProperties;
+  VkDeviceSize const mBufferImageGranularity;
+  VkDeviceSize const mNonCoherentAtomSize;
+  std::vector<std::unique_ptr<VulkanMemoryBlock>> mBlocks[VK_MAX_MEMORY_TYPES];
+};
+
+struct VulkanMemoryBlock {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize size = 0;
+  VkDeviceSize used = 0;
+  void* mapped = nullptr;
+  uint32_t memoryType = 0;
+  // Allocations larger than half a block get a block of their own.
+  bool dedicated = false;
+  // Being emptied by the defragmenter; no new allocations go here.
+  bool evacuating = false;
+  // selectEvacuationBlocks() calls left before the block may be picked
+  // again after a cancelled evacuation.
+  uint32_t evacuationCooldown = 0;
+  // Free ranges keyed by offset; adjacent ranges are always merged.
+  std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+};
+
+}  // namespace engine::backend
@@ -0,0 +1,117 @@
+#include "VulkanReadback.h"
+
+#include <assert.h>
+
+#include "absl/log/check.h"
+
+namespace engine::backend {
+
+namespace {
+
+inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // anonymous namespace
+
+VulkanReadbackRing::VulkanReadbackRing(VkDevice device,
+                                       VulkanAllocator& allocator,
+                                       VkDeviceSize capacity,
+                                       VkDeviceSize alignment)
+    : mDevice(device),
+      mAllocator(allocator),
+      mCapacity(alignUp(capacity, alignment)),
+      mAlignment(alignment) {
+  VkBufferCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  createInfo.size = mCapacity;
+  createInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  VkResult result = vkCreateBuffer(mDevice, &createInfo, nullptr, &mBuffer);
+  CHECK(result == VK_SUCCESS)
+      << "vkCreateBuffer error=" << static_cast<int32_t>(result);
+
+  VkMemoryRequirements requirements;
+  vkGetBufferMemoryRequirements(mDevice, mBuffer, &requirements);
+  mAllocation = mAllocator.allocate(requirements,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                    VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+  result = vkBindBufferMemory(mDevice, mBuffer, mAllocation.memory,
+                              mAllocation.offset);
+  CHECK(result == VK_SUCCESS)
+      << "vkBindBufferMemory error=" << static_cast<int32_t>(result);
+}
+
+VulkanReadbackRing::~VulkanReadbackRing() noexcept {
+  assert(mBuffer == VK_NULL_HANDLE);
+}
+
+void VulkanReadbackRing::terminate() noexcept {
+  vkDestroyBuffer(mDevice, mBuffer, nullptr);
+  mAllocator.free(mAllocation);
+  mBuffer = VK_NULL_HANDLE;
+  mReadbacks.clear();
+}
+
+VulkanReadback* VulkanReadbackRing::allocate(uint32_t byteCount,
+                                             uint64_t* id) {
+  VkDeviceSize const size = alignUp(byteCount, mAlignment);
+  VkDeviceSize offset;
+  if (mReadbacks.empty()) {
+    if (size > mCapacity) {
+      return nullptr;
+    }
+    offset = 0;
+  } else {
+    VkDeviceSize const tail = mReadbacks.front().offset;
+    if (mHead > tail) {
+      // Free space is [mHead, capacity) followed by [0, tail).
+      if (mHead + size <= mCapacity) {
+        offset = mHead;
+      } else if (size <= tail) {
+        offset = 0;
+      } else {
+        return nullptr;
+      }
+    } else {
+      // Wrapped; free space is [mHead, tail).
+      if (mHead + size > tail) {
+        return nullptr;
+      }
+      offset = mHead;
+    }
+  }
+
+  VulkanReadback readback;
+  readback.offset = offset;
+  readback.size = size;
+  readback.byteCount = byteCount;
+  mReadbacks.push_back(readback);
+  mHead = offset + size;
+  *id = mFirstId + mReadbacks.size() - 1;
+  return &mReadbacks.back();
+}
+
+VulkanReadback* VulkanReadbackRing::get(uint64_t id) noexcept {
+  if (id < mFirstId || id - mFirstId >= mReadbacks.size() ||
+      mReadbacks[id - mFirstId].released) {
+    return nullptr;
+  }
+  return &mReadbacks[id - mFirstId];
+}
+
+void VulkanReadbackRing::release(uint64_t id) noexcept {
+  VulkanReadback* readback = get(id);
+  if (!readback) {
+    return;
+  }
+  readback->released = true;
+  while (!mReadbacks.empty() && mReadbacks.front().released) {
+    mReadbacks.pop_front();
+    mFirstId++;
+  }
+  if (mReadbacks.empty()) {
+    mHead = 0;
+  }
+}
+
+}  // namespace engine::backend
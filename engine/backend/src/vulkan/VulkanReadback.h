@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+
+#include "VulkanMemory.h"
+#include "volk.h"
+
+namespace engine::backend {
+
+struct VulkanReadback {
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;  // bytes reserved in the ring
+  uint32_t byteCount = 0;
+  uint32_t rowPitch = 0;
+  // Timeline value of the submission that writes the data.
+  uint64_t value = 0;
+  bool invalidated = false;
+  bool released = false;
+};
+
+// Persistently mapped, host-cached buffer that readback copies land in.
+// Space is handed out in FIFO order and reclaimed from the oldest end once
+// the readbacks there have been released, so releases may come in any order
+// but a readback that is never released stalls the ring.
+class VulkanReadbackRing {
+ public:
+  VulkanReadbackRing(VkDevice device, VulkanAllocator& allocator,
+                     VkDeviceSize capacity, VkDeviceSize alignment);
+  ~VulkanReadbackRing() noexcept;
+
+  VulkanReadbackRing(VulkanReadbackRing const&) = delete;
+  VulkanReadbackRing& operator=(VulkanReadbackRing const&) = delete;
+
+  void terminate() noexcept;
+
+  // Reserves |byteCount| bytes. Returns nullptr when the ring is full.
+  VulkanReadback* allocate(uint32_t byteCount, uint64_t* id);
+
+  // Returns nullptr for unknown or released ids.
+  VulkanReadback* get(uint64_t id) noexcept;
+
+  void release(uint64_t id) noexcept;
+
+  VkBuffer getBuffer() const noexcept { return mBuffer; }
+
+  VulkanAllocation const& getAllocation() const noexcept {
+    return mAllocation;
+  }
+
+  uint8_t const* getData(VulkanReadback const& readback) const noexcept {
+    return static_cast<uint8_t const*>(mAllocation.mapped) + readback.offset;
+  }
+
+  VkDeviceSize getCapacity() const noexcept { return mCapacity; }
+
+ private:
+  VkDevice const mDevice;
+  VulkanAllocator& mAllocator;
+  VkDeviceSize const mCapacity;
+  VkDeviceSize const mAlignment;
+  VkBuffer mBuffer = VK_NULL_HANDLE;
+  VulkanAllocation mAllocation;
+
+  // Live readbacks, oldest first. The id of mReadbacks[i] is mFirstId + i;
+  // ids are 64-bit so that they never wrap.
+  std::deque<VulkanReadback> mReadbacks;
+  uint64_t mFirstId = 0;
+  // Offset one past the newest readback.
+  VkDeviceSize mHead = 0;
+};
+
+}  // namespace engine::backend
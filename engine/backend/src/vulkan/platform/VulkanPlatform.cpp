@@ -168,26 +168,72 @@ VkInstance createInstance(ExtensionSet const& requiredExts) {
   return mInstance;
 }
 
+ExtensionSet getDeviceExtensions(VkPhysicalDevice device) {
+  ExtensionSet const TARGET_EXTS = {
+      VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
+      VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+  };
+  ExtensionSet exts;
+  std::vector<VkExtensionProperties> const availableExts =
+      vkutils::enumerate(vkEnumerateDeviceExtensionProperties, device,
+                         static_cast<char const*>(nullptr));
+  for (auto const& extension : availableExts) {
+    std::string name{extension.extensionName};
+    if (setContains(TARGET_EXTS, name)) {
+      exts.insert(name);
+    }
+  }
+  return exts;
+}
+
 VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice,
-                             uint32_t graphicsQueueFamilyIndex) {
+                             uint32_t graphicsQueueFamilyIndex,
+                             uint32_t computeQueueFamilyIndex,
+                             uint32_t computeQueueIndex,
+                             ExtensionSet const& deviceExtensions) {
   VkDevice device;
-  float queuePriority[] = {1.0f};
+  float queuePriority[] = {1.0f, 1.0f};
   VkDeviceCreateInfo deviceCreateInfo{};
   deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
-  VkDeviceQueueCreateInfo deviceQueueCreateInfo{};
-  deviceQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-  deviceQueueCreateInfo.queueFamilyIndex = graphicsQueueFamilyIndex;
-  deviceQueueCreateInfo.queueCount = 1;
-  deviceQueueCreateInfo.pQueuePriorities = &queuePriority[0];
-
+  VkDeviceQueueCreateInfo deviceQueueCreateInfo[2] = {};
+  deviceQueueCreateInfo[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  deviceQueueCreateInfo[0].queueFamilyIndex = graphicsQueueFamilyIndex;
+  deviceQueueCreateInfo[0].queueCount = 1;
+  deviceQueueCreateInfo[0].pQueuePriorities = &queuePriority[0];
   deviceCreateInfo.queueCreateInfoCount = 1;
-  deviceCreateInfo.pQueueCreateInfos = &deviceQueueCreateInfo;
+
+  if (computeQueueFamilyIndex != graphicsQueueFamilyIndex) {
+    deviceQueueCreateInfo[1].sType =
+        VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    deviceQueueCreateInfo[1].queueFamilyIndex = computeQueueFamilyIndex;
+    deviceQueueCreateInfo[1].queueCount = 1;
+    deviceQueueCreateInfo[1].pQueuePriorities = &queuePriority[0];
+    deviceCreateInfo.queueCreateInfoCount = 2;
+  } else {
+    // A second queue of the graphics family, or the graphics queue itself.
+    deviceQueueCreateInfo[0].queueCount = computeQueueIndex + 1;
+  }
+  deviceCreateInfo.pQueueCreateInfos = deviceQueueCreateInfo;
 
   VkPhysicalDeviceFeatures enabledFeatures{};
   deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
 
-  deviceCreateInfo.enabledExtensionCount = 0;
+  VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures{};
+  timelineFeatures.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+  timelineFeatures.timelineSemaphore = VK_TRUE;
+  chainStruct(&deviceCreateInfo, &timelineFeatures);
+
+  constexpr uint32_t MAX_DEVICE_EXTENSION_COUNT = 8;
+  char const* ppEnabledExtensions[MAX_DEVICE_EXTENSION_COUNT];
+  uint32_t enabledExtensionCount = 0;
+  for (auto const& ext : deviceExtensions) {
+    assert(enabledExtensionCount < MAX_DEVICE_EXTENSION_COUNT);
+    ppEnabledExtensions[enabledExtensionCount++] = ext.data();
+  }
+  deviceCreateInfo.enabledExtensionCount = enabledExtensionCount;
+  deviceCreateInfo.ppEnabledExtensionNames = ppEnabledExtensions;
 
   VkResult result =
       vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device);
@@ -226,6 +272,28 @@ uint32_t identifyGraphicsQueueFamilyIndex(VkPhysicalDevice physicalDevice,
   return graphicsQueueFamilyIndex;
 }
 
+// Prefers a compute family without graphics so that dispatches can overlap
+// with rendering; otherwise falls back to the graphics family.
+uint32_t identifyComputeQueueFamilyIndex(VkPhysicalDevice physicalDevice,
+                                         uint32_t graphicsQueueFamilyIndex) {
+  const std::vector<VkQueueFamilyProperties> queueFamiliesProperties =
+      getPhysicalDeviceQueueFamilyPropertiesHelper(physicalDevice);
+  for (uint32_t j = 0; j < queueFamiliesProperties.size(); ++j) {
+    VkQueueFamilyProperties props = queueFamiliesProperties[j];
+    if (props.queueCount != 0 && (props.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+        !(props.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+      return j;
+    }
+  }
+  return graphicsQueueFamilyIndex;
+}
+
+uint32_t getQueueCount(VkPhysicalDevice physicalDevice, uint32_t familyIndex) {
+  return getPhysicalDeviceQueueFamilyPropertiesHelper(
+             physicalDevice)[familyIndex]
+      .queueCount;
+}
+
 inline int deviceTypeOrder(VkPhysicalDeviceType deviceType) {
   constexpr std::array<VkPhysicalDeviceType, 5> TYPES = {
       VK_PHYSICAL_DEVICE_TYPE_OTHER,
@@ -272,6 +340,11 @@ VkPhysicalDevice selectPhysicalDevice(VkInstance instance) {
       continue;
     }
 
+    if (!setContains(getDeviceExtensions(candidateDevice),
+                     VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)) {
+      continue;
+    }
+
     deviceList[deviceInd].device = candidateDevice;
     deviceList[deviceInd].deviceType = targetDeviceProperties.deviceType;
     deviceList[deviceInd].index = (int8_t)deviceInd;
@@ -323,16 +396,44 @@ Driver* VulkanPlatform::createDriver() noexcept {
 
   mGraphicsQueueIndex = 0;
 
-  mDevice = createLogicalDevice(mPhysicalDevice, mGraphicsQueueFamilyIndex);
+  mComputeQueueFamilyIndex = identifyComputeQueueFamilyIndex(
+      mPhysicalDevice, mGraphicsQueueFamilyIndex);
+  mComputeQueueIndex = 0;
+  if (mComputeQueueFamilyIndex == mGraphicsQueueFamilyIndex &&
+      getQueueCount(mPhysicalDevice, mGraphicsQueueFamilyIndex) > 1) {
+    mComputeQueueIndex = 1;
+  }
+
+  ExtensionSet const deviceExts = getDeviceExtensions(mPhysicalDevice);
+  CHECK(setContains(deviceExts, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+      << "Timeline semaphores are not supported.";
+
+  mDevice = createLogicalDevice(mPhysicalDevice, mGraphicsQueueFamilyIndex,
+                                mComputeQueueFamilyIndex, mComputeQueueIndex,
+                                deviceExts);
 
   assert(mDevice != VK_NULL_HANDLE);
   assert(mGraphicsQueueFamilyIndex != INVALID_VK_INDEX);
   assert(mGraphicsQueueIndex != INVALID_VK_INDEX);
 
+  volkLoadDevice(mDevice);
+
   vkGetDeviceQueue(mDevice, mGraphicsQueueFamilyIndex, mGraphicsQueueIndex,
                    &mGraphicsQueue);
   assert(mGraphicsQueue != VK_NULL_HANDLE);
 
+  vkGetDeviceQueue(mDevice, mComputeQueueFamilyIndex, mComputeQueueIndex,
+                   &mComputeQueue);
+  assert(mComputeQueue != VK_NULL_HANDLE);
+
+  context.mDedicatedComputeQueue = mComputeQueue != mGraphicsQueue;
+  context.mMemoryBudgetSupported =
+      setContains(deviceExts, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  vkGetPhysicalDeviceProperties(mPhysicalDevice,
+                                &context.mPhysicalDeviceProperties);
+  vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice,
+                                      &context.mMemoryProperties);
+
   context.mDebugUtilsSupported =
       setContains(instExts, VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
@@ -353,6 +454,9 @@ VulkanPlatform::VulkanPlatform()
       mGraphicsQueueFamilyIndex(INVALID_VK_INDEX),
       mGraphicsQueueIndex(INVALID_VK_INDEX),
       mGraphicsQueue(VK_NULL_HANDLE),
+      mComputeQueueFamilyIndex(INVALID_VK_INDEX),
+      mComputeQueueIndex(INVALID_VK_INDEX),
+      mComputeQueue(VK_NULL_HANDLE),
       mContext({}) {}
 
 VulkanPlatform::~VulkanPlatform() = default;
@@ -377,4 +481,16 @@ VkQueue VulkanPlatform::getGraphicsQueue() const noexcept {
   return mGraphicsQueue;
 }
 
+uint32_t VulkanPlatform::getComputeQueueFamilyIndex() const noexcept {
+  return mComputeQueueFamilyIndex;
+}
+
+uint32_t VulkanPlatform::getComputeQueueIndex() const noexcept {
+  return mComputeQueueIndex;
+}
+
+VkQueue VulkanPlatform::getComputeQueue() const noexcept {
+  return mComputeQueue;
+}
+
 }  // namespace engine::backend
@@ -0,0 +1,130 @@
+#include "vulkan/utils/Conversion.h"
+
+#include <algorithm>
+
+namespace engine::backend::vkutils {
+
+VkFormat getVkFormat(TextureFormat format) noexcept {
+  switch (format) {
+    case TextureFormat::R8:
+      return VK_FORMAT_R8_UNORM;
+    case TextureFormat::RG8:
+      return VK_FORMAT_R8G8_UNORM;
+    case TextureFormat::RGBA8:
+      return VK_FORMAT_R8G8B8A8_UNORM;
+    case TextureFormat::RGBA8_SRGB:
+      return VK_FORMAT_R8G8B8A8_SRGB;
+    case TextureFormat::R16F:
+      return VK_FORMAT_R16_SFLOAT;
+    case TextureFormat::RGBA16F:
+      return VK_FORMAT_R16G16B16A16_SFLOAT;
+    case TextureFormat::R32F:
+      return VK_FORMAT_R32_SFLOAT;
+    case TextureFormat::RG32F:
+      return VK_FORMAT_R32G32_SFLOAT;
+    case TextureFormat::RGBA32F:
+      return VK_FORMAT_R32G32B32A32_SFLOAT;
+    case TextureFormat::R32UI:
+      return VK_FORMAT_R32_UINT;
+    case TextureFormat::BC1_RGBA:
+      return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case TextureFormat::BC3_RGBA:
+      return VK_FORMAT_BC3_UNORM_BLOCK;
+    case TextureFormat::BC7_RGBA:
+      return VK_FORMAT_BC7_UNORM_BLOCK;
+  }
+  return VK_FORMAT_UNDEFINED;
+}
+
+VkDescriptorType getVkDescriptorType(DescriptorType type) noexcept {
+  switch (type) {
+    case DescriptorType::STORAGE_BUFFER:
+      return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    case DescriptorType::UNIFORM_BUFFER:
+      return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    case DescriptorType::STORAGE_IMAGE:
+      return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    case DescriptorType::SAMPLED_IMAGE:
+      return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  }
+  return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+}
+
+VkBufferUsageFlags getVkBufferUsage(BufferUsage usage) noexcept {
+  // Every buffer can be uploaded to, read back and relocated.
+  VkBufferUsageFlags flags =
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  if (any(usage, BufferUsage::STORAGE)) {
+    flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+  }
+  if (any(usage, BufferUsage::UNIFORM)) {
+    flags |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+  }
+  if (any(usage, BufferUsage::VERTEX)) {
+    flags |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+  }
+  if (any(usage, BufferUsage::INDEX)) {
+    flags |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+  }
+  if (any(usage, BufferUsage::INDIRECT)) {
+    flags |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+  }
+  return flags;
+}
+
+VkImageUsageFlags getVkImageUsage(TextureUsage usage) noexcept {
+  VkImageUsageFlags flags =
+      VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  if (any(usage, TextureUsage::SAMPLEABLE)) {
+    flags |= VK_IMAGE_USAGE_SAMPLED_BIT;
+  }
+  if (any(usage, TextureUsage::STORAGE)) {
+    flags |= VK_IMAGE_USAGE_STORAGE_BIT;
+  }
+  return flags;
+}
+
+uint32_t getBlockSize(TextureFormat format) noexcept {
+  switch (format) {
+    case TextureFormat::R8:
+      return 1;
+    case TextureFormat::RG8:
+    case TextureFormat::R16F:
+      return 2;
+    case TextureFormat::RGBA8:
+    case TextureFormat::RGBA8_SRGB:
+    case TextureFormat::R32F:
+    case TextureFormat::R32UI:
+      return 4;
+    case TextureFormat::RGBA16F:
+    case TextureFormat::RG32F:
+    case TextureFormat::BC1_RGBA:
+      return 8;
+    case TextureFormat::RGBA32F:
+    case TextureFormat::BC3_RGBA:
+    case TextureFormat::BC7_RGBA:
+      return 16;
+  }
+  return 0;
+}
+
+uint32_t getBlockDimension(TextureFormat format) noexcept {
+  switch (format) {
+    case TextureFormat::BC1_RGBA:
+    case TextureFormat::BC3_RGBA:
+    case TextureFormat::BC7_RGBA:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+uint64_t getLevelSize(TextureFormat format, uint32_t width, uint32_t height,
+                      uint32_t level) noexcept {
+  uint32_t const dim = getBlockDimension(format);
+  uint64_t const w = std::max(width >> level, 1u);
+  uint64_t const h = std::max(height >> level, 1u);
+  return ((w + dim - 1) / dim) * ((h + dim - 1) / dim) * getBlockSize(format);
+}
+
+}  // namespace engine::backend::vkutils
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "private/backend/DriverEnums.h"
+#include "volk.h"
+
+namespace engine::backend::vkutils {
+
+VkFormat getVkFormat(TextureFormat format) noexcept;
+
+VkDescriptorType getVkDescriptorType(DescriptorType type) noexcept;
+
+VkBufferUsageFlags getVkBufferUsage(BufferUsage usage) noexcept;
+
+VkImageUsageFlags getVkImageUsage(TextureUsage usage) noexcept;
+
+// Bytes per texel block and the block edge length in texels.
+uint32_t getBlockSize(TextureFormat format) noexcept;
+
+uint32_t getBlockDimension(TextureFormat format) noexcept;
+
+// Size of one tightly packed mip level.
+uint64_t getLevelSize(TextureFormat format, uint32_t width, uint32_t height,
+                      uint32_t level) noexcept;
+
+}  // namespace engine::backend::vkutils
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "lighting/ClusterGrid.h"
+#include "private/backend/Driver.h"
+
+namespace engine::lighting {
+
+// Builds the per-cluster light lists on the GPU. Lights are first culled one
+// invocation each into per-slice bit masks of tile columns and rows; each
+// cluster then tests only the lights set in both its masks. The lists are
+// the same as buildClusters() produces, sorted and capped to the lowest
+// indices, but packed in no particular cluster order. They stay in driver
+// buffers for the shading pass to bind:
+//   ranges:  one ClusterRange per cluster, indexed like ClusterGrid.
+//   indices: light indices.
+class ClusterBuilder {
+ public:
+  ClusterBuilder(backend::Driver* driver, ClusterConfig const& config);
+  ~ClusterBuilder() noexcept;
+
+  ClusterBuilder(ClusterBuilder const&) = delete;
+  ClusterBuilder& operator=(ClusterBuilder const&) = delete;
+
+  ClusterGrid const& getGrid() const noexcept { return mGrid; }
+
+  // Uploads |lights| (view space) and records the build. Returns the fence
+  // of the dispatch; the buffers may be read once it is signaled.
+  backend::GpuFence build(PointLight const* lights, uint32_t lightCount);
+
+  backend::BufferObjectHandle getLights() const noexcept { return mLights; }
+  backend::BufferObjectHandle getRanges() const noexcept { return mRanges; }
+  backend::BufferObjectHandle getIndices() const noexcept {
+    return mIndices;
+  }
+
+  uint32_t getIndexCapacity() const noexcept { return mIndexCapacity; }
+
+  // Copies the result of the last build back, waiting for it. Returns false
+  // if the index buffer overflowed and some lists were cut short; raise
+  // ClusterConfig::averageLightsPerCluster in that case. |cappedClusters|
+  // receives how many clusters had more than MAX_LIGHTS_PER_CLUSTER lights
+  // and kept only the lowest indices.
+  bool readBack(std::vector<ClusterRange>& ranges,
+                std::vector<uint32_t>& indices,
+                uint32_t* cappedClusters = nullptr);
+
+ private:
+  // Slices times tile columns plus slices times tile rows.
+  uint32_t getMaskCount() const noexcept;
+  static uint32_t getMaskWords(uint32_t lightCount) noexcept;
+
+  backend::Driver* const mDriver;
+  ClusterGrid const mGrid;
+  uint32_t const mIndexCapacity;
+  backend::ProgramHandle mProgram;
+  backend::BufferObjectHandle mLights;
+  backend::BufferObjectHandle mRanges;
+  backend::BufferObjectHandle mIndices;
+  backend::BufferObjectHandle mState;
+  // Light bit masks written by the cull pass; sized with mLights.
+  backend::BufferObjectHandle mMasks;
+  uint32_t mLightCapacity = 0;
+};
+
+}  // namespace engine::lighting
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace engine::lighting {
+
+// Lights are binned in view space: right handed, looking down -Z.
+// Matches the std430 layout of the GPU lights buffer.
+struct PointLight {
+  float position[3];
+  float radius;
+  float color[3];
+  float intensity;
+};
+
+static_assert(sizeof(PointLight) == 32, "PointLight must match std430");
+
+// Lights of one cluster are indices[offset, offset + count).
+struct ClusterRange {
+  uint32_t offset;
+  uint32_t count;
+};
+
+// Lights beyond this many in one cluster are dropped, highest indices first.
+constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 256;
+
+struct ClusterConfig {
+  // Screen tiles across and down, and depth slices.
+  uint32_t gridX = 16;
+  uint32_t gridY = 9;
+  uint32_t gridZ = 24;
+  float nearPlane = 0.1f;
+  float farPlane = 500.0f;
+  float fovY = 1.0471976f;  // radians
+  float aspect = 16.0f / 9.0f;
+  // Sizes the light index buffer of the GPU path.
+  uint32_t averageLightsPerCluster = 32;
+};
+
+// Froxel grid: the view frustum split into screen tiles and exponentially
+// spaced depth slices, so that clusters stay roughly cubic with distance.
+// Cluster (x, y, z) has index x + gridX * (y + gridY * z). Tile (0, 0) is
+// the bottom-left one, at view-space -X and -Y. Under the Vulkan projection
+// convention, where NDC +Y points down, that is NDC (-1, +1).
+class ClusterGrid {
+ public:
+  explicit ClusterGrid(ClusterConfig const& config) noexcept;
+
+  ClusterConfig const& getConfig() const noexcept { return mConfig; }
+
+  uint32_t getClusterCount() const noexcept {
+    return mConfig.gridX * mConfig.gridY * mConfig.gridZ;
+  }
+
+  uint32_t getClusterIndex(uint32_t x, uint32_t y, uint32_t z) const noexcept {
+    return x + mConfig.gridX * (y + mConfig.gridY * z);
+  }
+
+  // View-space distance of the near side of |slice|; slice gridZ is the far
+  // plane.
+  float getSliceDepth(uint32_t slice) const noexcept;
+
+  // Slice holding view-space distance |depth|, clamped to the grid.
+  uint32_t getSlice(float depth) const noexcept;
+
+  // Cluster a shaded point falls in, from its Vulkan NDC position (+Y down)
+  // and view-space distance; what the shading pass does to find its light
+  // list.
+  uint32_t findCluster(float ndcX, float ndcY, float depth) const noexcept;
+
+  // View-space bounding box of a cluster.
+  void getBounds(uint32_t x, uint32_t y, uint32_t z, float min[3],
+                 float max[3]) const noexcept;
+
+ private:
+  ClusterConfig const mConfig;
+  float const mTanHalfFovY;
+  float const mLogDepthRatio;  // log(far / near)
+};
+
+// CPU reference for the GPU cluster build. Each light only tests the
+// clusters of the depth slices its sphere spans. Lights of a cluster are
+// listed in increasing index order; past MAX_LIGHTS_PER_CLUSTER the rest
+// are dropped. Returns how many clusters were capped that way.
+uint32_t buildClusters(ClusterGrid const& grid, PointLight const* lights,
+                       uint32_t lightCount, std::vector<ClusterRange>& ranges,
+                       std::vector<uint32_t>& indices);
+
+// Sphere against box test used by both paths.
+bool intersects(PointLight const& light, float const min[3],
+                float const max[3]) noexcept;
+
+}  // namespace engine::lighting
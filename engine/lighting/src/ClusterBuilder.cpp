@@ -0,0 +1,179 @@
+#include "lighting/ClusterBuilder.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "absl/log/check.h"
+
+namespace engine::lighting {
+
+namespace {
+
+uint32_t const CLUSTER_LIGHTS_SPIRV[] = {
+#include "cluster_lights.comp.inc"
+};
+
+// Matches the Params block of cluster_lights.comp.
+struct PushConstants {
+  uint32_t grid[4];  // x, y, z, light count
+  float frustum[4];  // near, far, tan(fovY / 2), aspect
+  uint32_t indexCapacity;
+  uint32_t pass;
+};
+
+// The passes of cluster_lights.comp, in the order they run.
+enum Pass : uint32_t { PASS_CLEAR, PASS_CULL, PASS_BUILD, PASS_COUNT };
+
+static_assert(sizeof(PushConstants) <= backend::MAX_PUSH_CONSTANT_SIZE);
+
+// Matches the State block of cluster_lights.comp.
+struct State {
+  uint32_t indexCount;
+  uint32_t overflow;
+  uint32_t cappedClusters;
+};
+
+constexpr uint32_t MIN_LIGHT_CAPACITY = 256;
+// Workgroup size of cluster_lights.comp.
+constexpr uint32_t GROUP_SIZE = 64;
+
+}  // anonymous namespace
+
+ClusterBuilder::ClusterBuilder(backend::Driver* driver,
+                               ClusterConfig const& config)
+    : mDriver(driver),
+      mGrid(config),
+      mIndexCapacity(mGrid.getClusterCount() *
+                     std::max(config.averageLightsPerCluster, 1u)) {
+  CHECK(config.gridX && config.gridY && config.gridZ) << "Empty grid.";
+  CHECK(config.nearPlane > 0.0f && config.farPlane > config.nearPlane)
+      << "Invalid depth range.";
+
+  backend::ComputeProgramDesc desc;
+  desc.spirv = CLUSTER_LIGHTS_SPIRV;
+  desc.spirvSize = sizeof(CLUSTER_LIGHTS_SPIRV);
+  desc.bindings = {backend::DescriptorType::STORAGE_BUFFER,
+                   backend::DescriptorType::STORAGE_BUFFER,
+                   backend::DescriptorType::STORAGE_BUFFER,
+                   backend::DescriptorType::STORAGE_BUFFER,
+                   backend::DescriptorType::STORAGE_BUFFER};
+  desc.pushConstantSize = sizeof(PushConstants);
+  mProgram = mDriver->createComputeProgram(desc);
+
+  mRanges = mDriver->createBufferObject(
+      mGrid.getClusterCount() * sizeof(ClusterRange),
+      backend::BufferUsage::STORAGE);
+  mIndices = mDriver->createBufferObject(mIndexCapacity * sizeof(uint32_t),
+                                         backend::BufferUsage::STORAGE);
+  mState = mDriver->createBufferObject(sizeof(State),
+                                       backend::BufferUsage::STORAGE);
+}
+
+ClusterBuilder::~ClusterBuilder() noexcept {
+  if (mLights) {
+    mDriver->destroyBufferObject(mLights);
+    mDriver->destroyBufferObject(mMasks);
+  }
+  mDriver->destroyBufferObject(mState);
+  mDriver->destroyBufferObject(mIndices);
+  mDriver->destroyBufferObject(mRanges);
+  mDriver->destroyProgram(mProgram);
+}
+
+backend::GpuFence ClusterBuilder::build(PointLight const* lights,
+                                        uint32_t lightCount) {
+  if (!mLights || lightCount > mLightCapacity) {
+    // Grow geometrically so that a slowly rising light count does not
+    // reallocate every frame.
+    if (mLights) {
+      mDriver->destroyBufferObject(mLights);
+      mDriver->destroyBufferObject(mMasks);
+    }
+    mLightCapacity =
+        std::max({lightCount, mLightCapacity * 2, MIN_LIGHT_CAPACITY});
+    mLights = mDriver->createBufferObject(mLightCapacity * sizeof(PointLight),
+                                          backend::BufferUsage::STORAGE);
+    mMasks = mDriver->createBufferObject(
+        getMaskCount() * getMaskWords(mLightCapacity) * sizeof(uint32_t),
+        backend::BufferUsage::STORAGE);
+  }
+  if (lightCount) {
+    mDriver->updateBufferObject(mLights, lights,
+                                lightCount * sizeof(PointLight), 0);
+  }
+  State const state = {};
+  mDriver->updateBufferObject(mState, &state, sizeof(state), 0);
+
+  ClusterConfig const& config = mGrid.getConfig();
+  PushConstants constants = {};
+  constants.grid[0] = config.gridX;
+  constants.grid[1] = config.gridY;
+  constants.grid[2] = config.gridZ;
+  constants.grid[3] = lightCount;
+  constants.frustum[0] = config.nearPlane;
+  constants.frustum[1] = config.farPlane;
+  constants.frustum[2] = tanf(0.5f * config.fovY);
+  constants.frustum[3] = config.aspect;
+  constants.indexCapacity = mIndexCapacity;
+
+  // Each pass reads what the previous one wrote, so all of them keep the
+  // default barrier.
+  backend::ComputeDispatch dispatches[PASS_COUNT];
+  backend::BufferObjectHandle const buffers[] = {mLights, mRanges, mIndices,
+                                                 mState, mMasks};
+  for (uint32_t pass = 0; pass < PASS_COUNT; ++pass) {
+    backend::ComputeDispatch& dispatch = dispatches[pass];
+    dispatch.program = mProgram;
+    for (uint32_t i = 0; i < 5; ++i) {
+      backend::ComputeBinding binding;
+      binding.binding = i;
+      binding.buffer = buffers[i];
+      dispatch.bindings.push_back(binding);
+    }
+    constants.pass = pass;
+    dispatch.setPushConstants(&constants, sizeof(constants));
+  }
+  // One workgroup per mask.
+  dispatches[PASS_CLEAR].groupCount[0] = getMaskCount();
+  // One invocation per light.
+  dispatches[PASS_CULL].groupCount[0] =
+      (lightCount + GROUP_SIZE - 1) / GROUP_SIZE;
+  // One workgroup per cluster.
+  dispatches[PASS_BUILD].groupCount[0] = config.gridX;
+  dispatches[PASS_BUILD].groupCount[1] = config.gridY;
+  dispatches[PASS_BUILD].groupCount[2] = config.gridZ;
+  return mDriver->dispatchCompute(dispatches, PASS_COUNT);
+}
+
+uint32_t ClusterBuilder::getMaskCount() const noexcept {
+  ClusterConfig const& config = mGrid.getConfig();
+  return config.gridZ * (config.gridX + config.gridY);
+}
+
+uint32_t ClusterBuilder::getMaskWords(uint32_t lightCount) noexcept {
+  return (lightCount + 31) / 32;
+}
+
+bool ClusterBuilder::readBack(std::vector<ClusterRange>& ranges,
+                              std::vector<uint32_t>& indices,
+                              uint32_t* cappedClusters) {
+  State state;
+  mDriver->readBufferObject(mState, &state, sizeof(state), 0);
+  ranges.resize(mGrid.getClusterCount());
+  mDriver->readBufferObject(
+      mRanges, ranges.data(),
+      static_cast<uint32_t>(ranges.size() * sizeof(ClusterRange)), 0);
+  indices.resize(std::min(state.indexCount, mIndexCapacity));
+  if (!indices.empty()) {
+    mDriver->readBufferObject(
+        mIndices, indices.data(),
+        static_cast<uint32_t>(indices.size() * sizeof(uint32_t)), 0);
+  }
+  if (cappedClusters) {
+    *cappedClusters = state.cappedClusters;
+  }
+  return state.overflow == 0;
+}
+
+}  // namespace engine::lighting
@@ -0,0 +1,138 @@
+#include "lighting/ClusterGrid.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace engine::lighting {
+
+ClusterGrid::ClusterGrid(ClusterConfig const& config) noexcept
+    : mConfig(config),
+      mTanHalfFovY(tanf(0.5f * config.fovY)),
+      mLogDepthRatio(logf(config.farPlane / config.nearPlane)) {}
+
+float ClusterGrid::getSliceDepth(uint32_t slice) const noexcept {
+  // Written as pow() like the shader so both paths agree on the bounds.
+  return mConfig.nearPlane *
+         powf(mConfig.farPlane / mConfig.nearPlane,
+              float(slice) / float(mConfig.gridZ));
+}
+
+uint32_t ClusterGrid::getSlice(float depth) const noexcept {
+  if (depth <= mConfig.nearPlane) {
+    return 0;
+  }
+  float const slice =
+      logf(depth / mConfig.nearPlane) / mLogDepthRatio * float(mConfig.gridZ);
+  return std::min(static_cast<uint32_t>(slice), mConfig.gridZ - 1);
+}
+
+uint32_t ClusterGrid::findCluster(float ndcX, float ndcY,
+                                  float depth) const noexcept {
+  auto tile = [](float ndc, uint32_t count) {
+    float const t = (ndc * 0.5f + 0.5f) * float(count);
+    return std::min(static_cast<uint32_t>(std::max(t, 0.0f)), count - 1);
+  };
+  // Rows count up from view-space -Y, which is NDC +Y in Vulkan.
+  return getClusterIndex(tile(ndcX, mConfig.gridX),
+                         tile(-ndcY, mConfig.gridY), getSlice(depth));
+}
+
+void ClusterGrid::getBounds(uint32_t x, uint32_t y, uint32_t z, float min[3],
+                            float max[3]) const noexcept {
+  float const near = getSliceDepth(z);
+  float const far = getSliceDepth(z + 1);
+  float const scale[2] = {mTanHalfFovY * mConfig.aspect, mTanHalfFovY};
+  uint32_t const tile[2] = {x, y};
+  uint32_t const count[2] = {mConfig.gridX, mConfig.gridY};
+  for (int axis = 0; axis < 2; ++axis) {
+    // Tile edges on the plane at distance 1; the frustum widens with depth
+    // so the box spans both slice planes.
+    float const lo = (float(tile[axis]) / float(count[axis]) * 2.0f - 1.0f) *
+                     scale[axis];
+    float const hi =
+        (float(tile[axis] + 1) / float(count[axis]) * 2.0f - 1.0f) *
+        scale[axis];
+    min[axis] = std::min(lo * near, lo * far);
+    max[axis] = std::max(hi * near, hi * far);
+  }
+  min[2] = -far;
+  max[2] = -near;
+}
+
+bool intersects(PointLight const& light, float const min[3],
+                float const max[3]) noexcept {
+  float distance2 = 0.0f;
+  for (int i = 0; i < 3; ++i) {
+    float const closest = std::clamp(light.position[i], min[i], max[i]);
+    float const delta = closest - light.position[i];
+    distance2 += delta * delta;
+  }
+  return distance2 <= light.radius * light.radius;
+}
+
+uint32_t buildClusters(ClusterGrid const& grid, PointLight const* lights,
+                       uint32_t lightCount, std::vector<ClusterRange>& ranges,
+                       std::vector<uint32_t>& indices) {
+  ClusterConfig const& config = grid.getConfig();
+  uint32_t const clusterCount = grid.getClusterCount();
+
+  // Cluster bounds are the same for every light; compute them once.
+  std::vector<float> bounds(size_t(clusterCount) * 6);
+  for (uint32_t z = 0; z < config.gridZ; ++z) {
+    for (uint32_t y = 0; y < config.gridY; ++y) {
+      for (uint32_t x = 0; x < config.gridX; ++x) {
+        float* box = &bounds[size_t(grid.getClusterIndex(x, y, z)) * 6];
+        grid.getBounds(x, y, z, box, box + 3);
+      }
+    }
+  }
+
+  // Bin every light, then lay the lists out back to back. The lists are
+  // filled in light order, which keeps them sorted.
+  std::vector<std::vector<uint32_t>> lists(clusterCount);
+  std::vector<bool> capped(clusterCount);
+  uint32_t const tiles = config.gridX * config.gridY;
+  for (uint32_t i = 0; i < lightCount; ++i) {
+    PointLight const& light = lights[i];
+    float const depth = -light.position[2];
+    if (depth + light.radius < config.nearPlane ||
+        depth - light.radius > config.farPlane) {
+      continue;
+    }
+    // One extra slice on each side covers rounding differences between
+    // getSlice() and the slice bounds; the box test rejects the extras.
+    uint32_t const first = grid.getSlice(depth - light.radius);
+    uint32_t const last = grid.getSlice(depth + light.radius);
+    uint32_t const begin = first > 0 ? first - 1 : 0;
+    uint32_t const end = std::min(last + 1, config.gridZ - 1);
+    for (uint32_t z = begin; z <= end; ++z) {
+      for (uint32_t tile = 0; tile < tiles; ++tile) {
+        uint32_t const cluster = tile + tiles * z;
+        float const* box = &bounds[size_t(cluster) * 6];
+        if (!intersects(light, box, box + 3)) {
+          continue;
+        }
+        if (lists[cluster].size() < MAX_LIGHTS_PER_CLUSTER) {
+          lists[cluster].push_back(i);
+        } else {
+          capped[cluster] = true;
+        }
+      }
+    }
+  }
+
+  ranges.resize(clusterCount);
+  indices.clear();
+  uint32_t cappedClusters = 0;
+  for (uint32_t cluster = 0; cluster < clusterCount; ++cluster) {
+    cappedClusters += capped[cluster] ? 1 : 0;
+    ranges[cluster].offset = static_cast<uint32_t>(indices.size());
+    ranges[cluster].count = static_cast<uint32_t>(lists[cluster].size());
+    indices.insert(indices.end(), lists[cluster].begin(),
+                   lists[cluster].end());
+  }
+  return cappedClusters;
+}
+
+}  // namespace engine::lighting
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+// Set to 0 by the build to compile every recording call out.
+#ifndef ENGINE_METRICS
+#define ENGINE_METRICS 1
+#endif
+
+namespace engine::metrics {
+
+enum class Counter : uint8_t {
+  DRAWS,
+  DISPATCHES,
+  BARRIERS,
+  PIPELINE_BINDS,
+  DESCRIPTOR_UPDATES,
+  BYTES_UPLOADED,
+  ALLOCATIONS,
+  BYTES_ALLOCATED,
+  SUBMITS,
+};
+
+constexpr size_t COUNTER_COUNT = 9;
+
+enum class Histogram : uint8_t {
+  // CPU time spent in vkQueueSubmit.
+  QUEUE_SUBMIT_NS,
+  // From submission until the driver observes the work has completed.
+  SUBMIT_COMPLETE_NS,
+};
+
+constexpr size_t HISTOGRAM_COUNT = 2;
+
+// Bucket 0 counts zeros, bucket i > 0 counts values in [2^(i-1), 2^i) and
+// the last bucket everything above.
+constexpr size_t HISTOGRAM_BUCKETS = 48;
+
+char const* getName(Counter counter) noexcept;
+char const* getName(Histogram histogram) noexcept;
+
+struct HistogramData {
+  uint64_t buckets[HISTOGRAM_BUCKETS] = {};
+  uint64_t count = 0;
+  uint64_t sum = 0;
+
+  // Upper bound of the bucket holding the |fraction| quantile.
+  uint64_t getPercentile(float fraction) const noexcept;
+
+  double getMean() const noexcept {
+    return count ? double(sum) / double(count) : 0.0;
+  }
+};
+
+struct Snapshot {
+  // Number of endFrame() calls the snapshot covers up to.
+  uint64_t frame = 0;
+  uint64_t counters[COUNTER_COUNT] = {};
+  HistogramData histograms[HISTOGRAM_COUNT];
+
+  uint64_t get(Counter counter) const noexcept {
+    return counters[static_cast<size_t>(counter)];
+  }
+
+  HistogramData const& get(Histogram histogram) const noexcept {
+    return histograms[static_cast<size_t>(histogram)];
+  }
+};
+
+enum class DumpFormat : uint8_t {
+  JSON,
+  PROMETHEUS,
+};
+
+// Process-wide counters and histograms. Every thread records into its own
+// slot with plain relaxed stores, so recording never locks or contends;
+// endFrame() sums the slots. While disabled, recording is one relaxed load
+// and a branch, and nothing at all when built with ENGINE_METRICS=0.
+class Metrics {
+ public:
+  static bool isEnabled() noexcept {
+#if ENGINE_METRICS
+    return mEnabled.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+  }
+
+  static void setEnabled(bool enabled) noexcept;
+
+  static void add(Counter counter, uint64_t value = 1) noexcept {
+    if (isEnabled()) {
+      addSlow(counter, value);
+    }
+  }
+
+  static void record(Histogram histogram, uint64_t value) noexcept {
+    if (isEnabled()) {
+      recordSlow(histogram, value);
+    }
+  }
+
+  // Aggregates the per-thread values and writes the periodic dump when one
+  // is due. Call once per frame, from one thread.
+  static void endFrame();
+
+  // What was recorded between the last two endFrame() calls.
+  static Snapshot getFrame();
+
+  // Everything recorded up to the last endFrame() call.
+  static Snapshot getTotals();
+
+  // Rewrites |path| with the totals every |intervalFrames| frames. A null
+  // path or an interval of 0 stops dumping.
+  static void setDump(char const* path, DumpFormat format,
+                      uint32_t intervalFrames);
+
+  static std::string serialize(Snapshot const& snapshot, DumpFormat format);
+
+ private:
+  static void addSlow(Counter counter, uint64_t value) noexcept;
+  static void recordSlow(Histogram histogram, uint64_t value) noexcept;
+
+  static std::atomic<bool> mEnabled;
+};
+
+// Records the lifetime of the scope into |histogram|, in nanoseconds. The
+// clock is not read while metrics are disabled.
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Histogram histogram) noexcept
+      : mHistogram(histogram), mEnabled(Metrics::isEnabled()) {
+    if (mEnabled) {
+      mStart = Clock::now();
+    }
+  }
+
+  ~ScopedTimer() noexcept {
+    if (mEnabled) {
+      auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now() - mStart);
+      Metrics::record(mHistogram, static_cast<uint64_t>(elapsed.count()));
+    }
+  }
+
+  ScopedTimer(ScopedTimer const&) = delete;
+  ScopedTimer& operator=(ScopedTimer const&) = delete;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  Histogram const mHistogram;
+  bool const mEnabled;
+  Clock::time_point mStart;
+};
+
+}  // namespace engine::metrics
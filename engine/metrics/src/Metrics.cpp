@@ -0,0 +1,329 @@
+#include "metrics/Metrics.h"
+
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#include "absl/log/log.h"
+
+namespace engine::metrics {
+
+namespace {
+
+// Written only by the thread that owns it, read by endFrame().
+struct ThreadSlot {
+  ThreadSlot() noexcept {
+    for (auto& counter : counters) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    for (auto& histogram : histograms) {
+      for (auto& bucket : histogram.buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+      }
+      histogram.count.store(0, std::memory_order_relaxed);
+      histogram.sum.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  struct Histogram {
+    std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+  };
+
+  std::atomic<uint64_t> counters[COUNTER_COUNT];
+  Histogram histograms[HISTOGRAM_COUNT];
+  // Cleared when the owning thread exits so another thread can take the
+  // slot over. What was recorded stays part of the totals.
+  std::atomic<bool> owned{true};
+  ThreadSlot* next = nullptr;
+};
+
+struct Registry {
+  // Slots are pushed at the head and never removed.
+  std::atomic<ThreadSlot*> slots{nullptr};
+
+  std::mutex mutex;
+  Snapshot totals;
+  Snapshot frame;
+  std::string dumpPath;
+  DumpFormat dumpFormat = DumpFormat::JSON;
+  uint32_t dumpInterval = 0;
+};
+
+Registry& getRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+ThreadSlot* acquireSlot() {
+  Registry& registry = getRegistry();
+  for (ThreadSlot* slot = registry.slots.load(std::memory_order_acquire);
+       slot; slot = slot->next) {
+    bool owned = false;
+    if (!slot->owned.load(std::memory_order_relaxed) &&
+        slot->owned.compare_exchange_strong(owned, true,
+                                            std::memory_order_acquire)) {
+      return slot;
+    }
+  }
+  auto* slot = new ThreadSlot();
+  ThreadSlot* head = registry.slots.load(std::memory_order_relaxed);
+  do {
+    slot->next = head;
+  } while (!registry.slots.compare_exchange_weak(
+      head, slot, std::memory_order_release, std::memory_order_relaxed));
+  return slot;
+}
+
+struct SlotOwner {
+  ~SlotOwner() {
+    if (slot) {
+      slot->owned.store(false, std::memory_order_release);
+    }
+  }
+
+  ThreadSlot* slot = nullptr;
+};
+
+thread_local SlotOwner tSlotOwner;
+
+inline ThreadSlot& getSlot() {
+  if (!tSlotOwner.slot) {
+    tSlotOwner.slot = acquireSlot();
+  }
+  return *tSlotOwner.slot;
+}
+
+// Only the owning thread writes a slot, so a load and a store suffice.
+inline void bump(std::atomic<uint64_t>& value, uint64_t delta) noexcept {
+  value.store(value.load(std::memory_order_relaxed) + delta,
+              std::memory_order_relaxed);
+}
+
+inline size_t getBucket(uint64_t value) noexcept {
+  size_t bucket = 0;
+  while (value && bucket < HISTOGRAM_BUCKETS - 1) {
+    value >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+Snapshot aggregate(Registry& registry) {
+  Snapshot snapshot;
+  for (ThreadSlot* slot = registry.slots.load(std::memory_order_acquire);
+       slot; slot = slot->next) {
+    for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+      snapshot.counters[i] +=
+          slot->counters[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < HISTOGRAM_COUNT; ++i) {
+      HistogramData& data = snapshot.histograms[i];
+      ThreadSlot::Histogram const& histogram = slot->histograms[i];
+      for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+        data.buckets[b] += histogram.buckets[b].load(std::memory_order_relaxed);
+      }
+      data.count += histogram.count.load(std::memory_order_relaxed);
+      data.sum += histogram.sum.load(std::memory_order_relaxed);
+    }
+  }
+  return snapshot;
+}
+
+Snapshot subtract(Snapshot const& current, Snapshot const& previous) {
+  Snapshot delta;
+  delta.frame = current.frame;
+  for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+    delta.counters[i] = current.counters[i] - previous.counters[i];
+  }
+  for (size_t i = 0; i < HISTOGRAM_COUNT; ++i) {
+    HistogramData const& a = current.histograms[i];
+    HistogramData const& b = previous.histograms[i];
+    for (size_t bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+      delta.histograms[i].buckets[bucket] =
+          a.buckets[bucket] - b.buckets[bucket];
+    }
+    delta.histograms[i].count = a.count - b.count;
+    delta.histograms[i].sum = a.sum - b.sum;
+  }
+  return delta;
+}
+
+uint64_t getBucketBound(size_t bucket) noexcept {
+  return bucket == 0 ? 0 : (uint64_t(1) << bucket) - 1;
+}
+
+void writeJson(std::ostream& out, Snapshot const& snapshot) {
+  out << "{\n  \"frame\": " << snapshot.frame << ",\n  \"counters\": {";
+  for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+    out << (i ? ",\n" : "\n") << "    \""
+        << getName(static_cast<Counter>(i)) << "\": " << snapshot.counters[i];
+  }
+  out << "\n  },\n  \"histograms\": {";
+  for (size_t i = 0; i < HISTOGRAM_COUNT; ++i) {
+    HistogramData const& data = snapshot.histograms[i];
+    out << (i ? ",\n" : "\n") << "    \""
+        << getName(static_cast<Histogram>(i)) << "\": {\"count\": "
+        << data.count << ", \"sum\": " << data.sum
+        << ", \"p50\": " << data.getPercentile(0.5f)
+        << ", \"p99\": " << data.getPercentile(0.99f) << ", \"buckets\": [";
+    // Trailing empty buckets are left out.
+    size_t used = HISTOGRAM_BUCKETS;
+    while (used > 0 && data.buckets[used - 1] == 0) {
+      used--;
+    }
+    for (size_t b = 0; b < used; ++b) {
+      out << (b ? ", " : "") << data.buckets[b];
+    }
+    out << "]}";
+  }
+  out << "\n  }\n}\n";
+}
+
+void writePrometheus(std::ostream& out, Snapshot const& snapshot) {
+  for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+    char const* name = getName(static_cast<Counter>(i));
+    out << "# TYPE engine_" << name << "_total counter\n"
+        << "engine_" << name << "_total " << snapshot.counters[i] << "\n";
+  }
+  for (size_t i = 0; i < HISTOGRAM_COUNT; ++i) {
+    char const* name = getName(static_cast<Histogram>(i));
+    HistogramData const& data = snapshot.histograms[i];
+    out << "# TYPE engine_" << name << " histogram\n";
+    uint64_t cumulative = 0;
+    for (size_t b = 0; b + 1 < HISTOGRAM_BUCKETS; ++b) {
+      cumulative += data.buckets[b];
+      out << "engine_" << name << "_bucket{le=\"" << getBucketBound(b)
+          << "\"} " << cumulative << "\n";
+    }
+    out << "engine_" << name << "_bucket{le=\"+Inf\"} " << data.count << "\n"
+        << "engine_" << name << "_sum " << data.sum << "\n"
+        << "engine_" << name << "_count " << data.count << "\n";
+  }
+}
+
+}  // anonymous namespace
+
+std::atomic<bool> Metrics::mEnabled{false};
+
+char const* getName(Counter counter) noexcept {
+  switch (counter) {
+    case Counter::DRAWS:
+      return "draws";
+    case Counter::DISPATCHES:
+      return "dispatches";
+    case Counter::BARRIERS:
+      return "barriers";
+    case Counter::PIPELINE_BINDS:
+      return "pipeline_binds";
+    case Counter::DESCRIPTOR_UPDATES:
+      return "descriptor_updates";
+    case Counter::BYTES_UPLOADED:
+      return "bytes_uploaded";
+    case Counter::ALLOCATIONS:
+      return "allocations";
+    case Counter::BYTES_ALLOCATED:
+      return "bytes_allocated";
+    case Counter::SUBMITS:
+      return "submits";
+  }
+  return "unknown";
+}
+
+char const* getName(Histogram histogram) noexcept {
+  switch (histogram) {
+    case Histogram::QUEUE_SUBMIT_NS:
+      return "queue_submit_ns";
+    case Histogram::SUBMIT_COMPLETE_NS:
+      return "submit_complete_ns";
+  }
+  return "unknown";
+}
+
+uint64_t HistogramData::getPercentile(float fraction) const noexcept {
+  if (count == 0) {
+    return 0;
+  }
+  uint64_t const rank = static_cast<uint64_t>(fraction * double(count - 1));
+  uint64_t seen = 0;
+  for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+    seen += buckets[b];
+    if (seen > rank) {
+      return getBucketBound(b);
+    }
+  }
+  return getBucketBound(HISTOGRAM_BUCKETS - 1);
+}
+
+void Metrics::setEnabled(bool enabled) noexcept {
+#if ENGINE_METRICS
+  mEnabled.store(enabled, std::memory_order_relaxed);
+#else
+  if (enabled) {
+    LOG(WARNING) << "Metrics were compiled out (ENGINE_METRICS=0).";
+  }
+#endif
+}
+
+void Metrics::addSlow(Counter counter, uint64_t value) noexcept {
+  bump(getSlot().counters[static_cast<size_t>(counter)], value);
+}
+
+void Metrics::recordSlow(Histogram histogram, uint64_t value) noexcept {
+  ThreadSlot::Histogram& data =
+      getSlot().histograms[static_cast<size_t>(histogram)];
+  bump(data.buckets[getBucket(value)], 1);
+  bump(data.count, 1);
+  bump(data.sum, value);
+}
+
+void Metrics::endFrame() {
+  Registry& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  Snapshot totals = aggregate(registry);
+  totals.frame = registry.totals.frame + 1;
+  registry.frame = subtract(totals, registry.totals);
+  registry.totals = totals;
+
+  if (registry.dumpInterval && totals.frame % registry.dumpInterval == 0) {
+    std::ofstream out(registry.dumpPath, std::ios::trunc);
+    out << serialize(totals, registry.dumpFormat);
+    if (!out.good()) {
+      LOG(ERROR) << "Unable to write metrics to " << registry.dumpPath;
+    }
+  }
+}
+
+Snapshot Metrics::getFrame() {
+  Registry& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  return registry.frame;
+}
+
+Snapshot Metrics::getTotals() {
+  Registry& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  return registry.totals;
+}
+
+void Metrics::setDump(char const* path, DumpFormat format,
+                      uint32_t intervalFrames) {
+  Registry& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.dumpPath = path ? path : "";
+  registry.dumpFormat = format;
+  registry.dumpInterval = path ? intervalFrames : 0;
+}
+
+std::string Metrics::serialize(Snapshot const& snapshot, DumpFormat format) {
+  std::ostringstream out;
+  if (format == DumpFormat::JSON) {
+    writeJson(out, snapshot);
+  } else {
+    writePrometheus(out, snapshot);
+  }
+  return out.str();
+}
+
+}  // namespace engine::metrics
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// On-disk layout of an engine asset package.
+//
+//   +--------------------+  offset 0
+//   | PackageHeader      |
+//   +--------------------+  kChunkAlignment
+//   | chunk payload 0    |
+//   +--------------------+  kChunkAlignment
+//   | ...                |
+//   +--------------------+  PackageHeader::tocOffset
+//   | ChunkEntry[count]  |
+//   +--------------------+
+//
+// Payloads are stored in exactly the layout the GPU consumes (interleaved
+// vertices, packed indices, tightly packed mip levels) so that an
+// uncompressed chunk can be copied straight from the file mapping into a
+// staging buffer. All fields are little-endian.
+
+namespace engine::package {
+
+constexpr uint32_t kPackageMagic = 0x4B504556;  // "VEPK"
+constexpr uint32_t kPackageVersion = 1;
+constexpr uint64_t kChunkAlignment = 256;
+constexpr size_t kChunkNameLength = 32;
+constexpr size_t kMaxVertexAttributes = 8;
+
+enum class ChunkType : uint32_t {
+  VERTEX_BUFFER = 0,
+  INDEX_BUFFER = 1,
+  TEXTURE = 2,
+  MESHLETS = 3,
+  BLOB = 4,
+};
+
+enum class Compression : uint32_t {
+  NONE = 0,
+  LZ4 = 1,
+  ZSTD = 2,
+};
+
+enum class VertexSemantic : uint8_t {
+  POSITION = 0,
+  NORMAL = 1,
+  TANGENT = 2,
+  COLOR = 3,
+  UV0 = 4,
+  UV1 = 5,
+};
+
+// Attribute formats mirror the Vulkan formats the backend binds them as.
+enum class VertexFormat : uint8_t {
+  FLOAT2 = 0,
+  FLOAT3 = 1,
+  FLOAT4 = 2,
+  HALF2 = 3,
+  HALF4 = 4,
+  SHORT4_NORM = 5,   // 16-bit quantized positions
+  SHORT2_NORM = 6,   // octahedral normals
+  UBYTE4_NORM = 7,
+};
+
+enum class IndexType : uint32_t {
+  UINT16 = 0,
+  UINT32 = 1,
+};
+
+enum class PixelFormat : uint32_t {
+  R8_UNORM = 0,
+  RG8_UNORM = 1,
+  RGBA8_UNORM = 2,
+  RGBA8_SRGB = 3,
+  RGBA16_FLOAT = 4,
+  RGBA32_FLOAT = 5,
+  BC1_UNORM = 6,
+  BC3_UNORM = 7,
+  BC7_UNORM = 8,
+};
+
+struct PackageHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t chunkCount;
+  uint32_t reserved;
+  uint64_t tocOffset;
+  uint64_t fileSize;
+};
+static_assert(sizeof(PackageHeader) == 32);
+
+struct VertexAttribute {
+  VertexSemantic semantic;
+  VertexFormat format;
+  uint16_t offset;
+};
+
+struct VertexBufferDesc {
+  uint32_t vertexCount;
+  uint16_t stride;
+  uint16_t attributeCount;
+  VertexAttribute attributes[kMaxVertexAttributes];
+  // Dequantization transform for SHORT4_NORM positions: p = q * scale + bias.
+  float positionScale[3];
+  float positionBias[3];
+};
+
+struct IndexBufferDesc {
+  uint32_t indexCount;
+  IndexType indexType;
+};
+
+// Mip levels are stored smallest first so that the mip tail is a contiguous
+// prefix of the chunk and can be made resident with a single read.
+struct TextureDesc {
+  PixelFormat format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t levels;
+};
+
+struct MeshletsDesc {
+  uint32_t meshletCount;
+  uint32_t maxVertices;
+  uint32_t maxTriangles;
+  uint32_t vertexIndexOffset;    // byte offset of the meshlet vertex indices
+  uint32_t triangleIndexOffset;  // byte offset of the packed triangle bytes
+};
+
+// Payload layout of a MESHLETS chunk: MeshletDesc[meshletCount], followed by
+// uint32_t vertex indices and uint8_t triangle corners (padded to 4 bytes per
+// meshlet). A meshlet is backfacing from |camera| and can be culled when
+//   dot(center - camera, coneAxis) >=
+//       coneCutoff * length(center - camera) + radius.
+struct MeshletDesc {
+  uint32_t vertexOffset;
+  uint32_t triangleOffset;
+  uint32_t vertexCount;
+  uint32_t triangleCount;
+  float center[3];
+  float radius;
+  float coneAxis[3];
+  float coneCutoff;
+};
+static_assert(sizeof(MeshletDesc) == 48);
+
+struct ChunkEntry {
+  ChunkType type;
+  Compression compression;
+  uint64_t offset;      // from the start of the file
+  uint64_t storedSize;  // bytes occupied in the file
+  uint64_t size;        // bytes once decompressed
+  char name[kChunkNameLength];
+  union {
+    VertexBufferDesc vertex;
+    IndexBufferDesc index;
+    TextureDesc texture;
+    MeshletsDesc meshlets;
+    uint8_t raw[72];
+  };
+};
+static_assert(sizeof(VertexBufferDesc) <= 72);
+static_assert(sizeof(ChunkEntry) == 136);
+
+// Size of one block of the given format; uncompressed formats use 1x1 blocks.
+uint32_t getBlockSize(PixelFormat format) noexcept;
+
+uint32_t getBlockDimension(PixelFormat format) noexcept;
+
+uint64_t getMipSize(TextureDesc const& desc, uint32_t level) noexcept;
+
+// Byte offset of |level| inside a TEXTURE chunk.
+uint64_t getMipOffset(TextureDesc const& desc, uint32_t level) noexcept;
+
+// Returns false if the codec was not found when the engine was configured.
+// The writer then stores such chunks uncompressed.
+bool isCompressionSupported(Compression compression) noexcept;
+
+}  // namespace engine::package
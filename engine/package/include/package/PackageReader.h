@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "package/PackageFormat.h"
+
+namespace engine::package {
+
+class MappedFile;
+
+// Memory-maps a package and hands out views of its chunks. Uncompressed
+// chunks are never copied by the reader; callers copy them directly from the
+// mapping into their destination (typically a mapped staging buffer).
+class PackageReader {
+ public:
+  struct ReadRequest {
+    uint32_t chunk;
+    void* dst;  // must hold ChunkEntry::size bytes
+  };
+
+  PackageReader() noexcept;
+  ~PackageReader() noexcept;
+
+  PackageReader(PackageReader const&) = delete;
+  PackageReader& operator=(PackageReader const&) = delete;
+
+  // Maps the file and validates its header and table of contents.
+  bool open(char const* path) noexcept;
+
+  void close() noexcept;
+
+  bool isOpen() const noexcept;
+
+  uint32_t getChunkCount() const noexcept;
+
+  ChunkEntry const& getChunk(uint32_t index) const noexcept;
+
+  // Returns -1 if no chunk of that type has that name.
+  int32_t findChunk(ChunkType type, char const* name) const noexcept;
+
+  // Pointer into the mapping, or nullptr if the chunk is compressed.
+  uint8_t const* getChunkData(uint32_t index) const noexcept;
+
+  // Copies a byte range of an uncompressed chunk. Compressed chunks can only
+  // be read whole.
+  bool readChunkRange(uint32_t index, uint64_t offset, uint64_t size,
+                      void* dst) const noexcept;
+
+  bool readChunk(uint32_t index, void* dst) const noexcept;
+
+  // Reads or decompresses every request, spreading them over |threadCount|
+  // workers (0 selects the hardware concurrency).
+  bool readChunks(ReadRequest const* requests, size_t count,
+                  uint32_t threadCount = 0) const noexcept;
+
+ private:
+  std::unique_ptr<MappedFile> mFile;
+  ChunkEntry const* mEntries = nullptr;
+  uint32_t mChunkCount = 0;
+};
+
+}  // namespace engine::package
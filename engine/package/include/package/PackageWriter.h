@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "package/PackageFormat.h"
+
+namespace engine::package {
+
+// Builds a package in memory and writes it out in one go. Payloads must
+// already be in their GPU layout; the writer only compresses and aligns them.
+class PackageWriter {
+ public:
+  uint32_t addVertexBuffer(char const* name, VertexBufferDesc const& desc,
+                           void const* data, size_t size,
+                           Compression compression = Compression::NONE);
+
+  uint32_t addIndexBuffer(char const* name, IndexBufferDesc const& desc,
+                          void const* data, size_t size,
+                          Compression compression = Compression::NONE);
+
+  // |data| holds the mip levels smallest first, see getMipOffset().
+  uint32_t addTexture(char const* name, TextureDesc const& desc,
+                      void const* data, size_t size,
+                      Compression compression = Compression::NONE);
+
+  uint32_t addMeshlets(char const* name, MeshletsDesc const& desc,
+                       void const* data, size_t size,
+                       Compression compression = Compression::NONE);
+
+  uint32_t addBlob(char const* name, void const* data, size_t size,
+                   Compression compression = Compression::NONE);
+
+  // Total bytes of chunk payloads as stored in the file.
+  uint64_t getStoredSize() const noexcept;
+
+  bool write(char const* path) const;
+
+ private:
+  struct Chunk {
+    ChunkEntry entry;
+    std::vector<uint8_t> payload;
+  };
+
+  uint32_t addChunk(ChunkType type, char const* name, void const* desc,
+                    size_t descSize, void const* data, size_t size,
+                    Compression compression);
+
+  std::vector<Chunk> mChunks;
+};
+
+}  // namespace engine::package
@@ -0,0 +1,111 @@
+#include "Compression.h"
+
+#include <string.h>
+
+#if PACKAGE_HAS_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+#if PACKAGE_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace engine::package {
+
+namespace {
+
+#if PACKAGE_HAS_ZSTD
+constexpr int kZstdLevel = 19;
+#endif
+
+}  // anonymous namespace
+
+bool isCompressionSupported(Compression compression) noexcept {
+  switch (compression) {
+    case Compression::NONE:
+      return true;
+    case Compression::LZ4:
+      return PACKAGE_HAS_LZ4;
+    case Compression::ZSTD:
+      return PACKAGE_HAS_ZSTD;
+  }
+  return false;
+}
+
+bool compress(Compression compression, void const* src, size_t size,
+              std::vector<uint8_t>& out) {
+  switch (compression) {
+    case Compression::NONE:
+      out.resize(size);
+      memcpy(out.data(), src, size);
+      return true;
+    case Compression::LZ4:
+#if PACKAGE_HAS_LZ4
+    {
+      if (size > LZ4_MAX_INPUT_SIZE) {
+        return false;
+      }
+      out.resize(LZ4_compressBound(static_cast<int>(size)));
+      int const written = LZ4_compress_HC(
+          static_cast<char const*>(src), reinterpret_cast<char*>(out.data()),
+          static_cast<int>(size), static_cast<int>(out.size()),
+          LZ4HC_CLEVEL_MAX);
+      if (written <= 0) {
+        return false;
+      }
+      out.resize(static_cast<size_t>(written));
+      return true;
+    }
+#else
+      return false;
+#endif
+    case Compression::ZSTD:
+#if PACKAGE_HAS_ZSTD
+    {
+      out.resize(ZSTD_compressBound(size));
+      size_t const written =
+          ZSTD_compress(out.data(), out.size(), src, size, kZstdLevel);
+      if (ZSTD_isError(written)) {
+        return false;
+      }
+      out.resize(written);
+      return true;
+    }
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+bool decompress(Compression compression, void const* src, size_t storedSize,
+                void* dst, size_t size) noexcept {
+  switch (compression) {
+    case Compression::NONE:
+      if (storedSize != size) {
+        return false;
+      }
+      memcpy(dst, src, size);
+      return true;
+    case Compression::LZ4:
+#if PACKAGE_HAS_LZ4
+      return LZ4_decompress_safe(static_cast<char const*>(src),
+                                 static_cast<char*>(dst),
+                                 static_cast<int>(storedSize),
+                                 static_cast<int>(size)) ==
+             static_cast<int>(size);
+#else
+      return false;
+#endif
+    case Compression::ZSTD:
+#if PACKAGE_HAS_ZSTD
+      return ZSTD_decompress(dst, size, src, storedSize) == size;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+}  // namespace engine::package
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "package/PackageFormat.h"
+
+namespace engine::package {
+
+bool compress(Compression compression, void const* src, size_t size,
+              std::vector<uint8_t>& out);
+
+// |dst| must hold exactly |size| bytes, the decompressed size of the chunk.
+bool decompress(Compression compression, void const* src, size_t storedSize,
+                void* dst, size_t size) noexcept;
+
+}  // namespace engine::package
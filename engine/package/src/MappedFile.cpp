@@ -0,0 +1,110 @@
+#include "MappedFile.h"
+
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine::package {
+
+MappedFile::~MappedFile() noexcept { close(); }
+
+#if defined(WIN32)
+
+bool MappedFile::open(char const* path) noexcept {
+  close();
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    return false;
+  }
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  mFile = file;
+  mMapping = mapping;
+  mData = static_cast<uint8_t const*>(data);
+  mSize = static_cast<size_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::close() noexcept {
+  if (mData) {
+    UnmapViewOfFile(mData);
+    CloseHandle(mMapping);
+    CloseHandle(mFile);
+  }
+  mData = nullptr;
+  mSize = 0;
+  mFile = nullptr;
+  mMapping = nullptr;
+}
+
+void MappedFile::prefetch(size_t offset, size_t size) const noexcept {
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = const_cast<uint8_t*>(mData + offset);
+  range.NumberOfBytes = size;
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+bool MappedFile::open(char const* path) noexcept {
+  close();
+  int const fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                    MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  mData = static_cast<uint8_t const*>(data);
+  mSize = static_cast<size_t>(st.st_size);
+  return true;
+}
+
+void MappedFile::close() noexcept {
+  if (mData) {
+    munmap(const_cast<uint8_t*>(mData), mSize);
+  }
+  mData = nullptr;
+  mSize = 0;
+}
+
+void MappedFile::prefetch(size_t offset, size_t size) const noexcept {
+  size_t const page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t const begin = offset & ~(page - 1);
+  madvise(const_cast<uint8_t*>(mData + begin), size + (offset - begin),
+          MADV_WILLNEED);
+}
+
+#endif
+
+}  // namespace engine::package
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace engine::package {
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+ public:
+  MappedFile() noexcept = default;
+  ~MappedFile() noexcept;
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+
+  bool open(char const* path) noexcept;
+
+  void close() noexcept;
+
+  uint8_t const* data() const noexcept { return mData; }
+
+  size_t size() const noexcept { return mSize; }
+
+  // Asks the OS to start paging in the given range ahead of use.
+  void prefetch(size_t offset, size_t size) const noexcept;
+
+ private:
+  uint8_t const* mData = nullptr;
+  size_t mSize = 0;
+#if defined(WIN32)
+  void* mFile = nullptr;
+  void* mMapping = nullptr;
+#endif
+};
+
+}  // namespace engine::package
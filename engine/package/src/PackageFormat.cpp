@@ -0,0 +1,55 @@
+#include "package/PackageFormat.h"
+
+#include <algorithm>
+
+namespace engine::package {
+
+uint32_t getBlockSize(PixelFormat format) noexcept {
+  switch (format) {
+    case PixelFormat::R8_UNORM:
+      return 1;
+    case PixelFormat::RG8_UNORM:
+      return 2;
+    case PixelFormat::RGBA8_UNORM:
+    case PixelFormat::RGBA8_SRGB:
+      return 4;
+    case PixelFormat::RGBA16_FLOAT:
+    case PixelFormat::BC1_UNORM:
+      return 8;
+    case PixelFormat::RGBA32_FLOAT:
+    case PixelFormat::BC3_UNORM:
+    case PixelFormat::BC7_UNORM:
+      return 16;
+  }
+  return 0;
+}
+
+uint32_t getBlockDimension(PixelFormat format) noexcept {
+  switch (format) {
+    case PixelFormat::BC1_UNORM:
+    case PixelFormat::BC3_UNORM:
+    case PixelFormat::BC7_UNORM:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+uint64_t getMipSize(TextureDesc const& desc, uint32_t level) noexcept {
+  uint32_t const dim = getBlockDimension(desc.format);
+  uint64_t const width = std::max(desc.width >> level, 1u);
+  uint64_t const height = std::max(desc.height >> level, 1u);
+  uint64_t const blocksX = (width + dim - 1) / dim;
+  uint64_t const blocksY = (height + dim - 1) / dim;
+  return blocksX * blocksY * getBlockSize(desc.format);
+}
+
+uint64_t getMipOffset(TextureDesc const& desc, uint32_t level) noexcept {
+  uint64_t offset = 0;
+  for (uint32_t i = desc.levels; i-- > level + 1;) {
+    offset += getMipSize(desc, i);
+  }
+  return offset;
+}
+
+}  // namespace engine::package
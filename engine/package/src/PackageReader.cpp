@@ -0,0 +1,176 @@
+#include "package/PackageReader.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Compression.h"
+#include "MappedFile.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+
+namespace engine::package {
+
+PackageReader::PackageReader() noexcept : mFile(new MappedFile()) {}
+
+PackageReader::~PackageReader() noexcept = default;
+
+bool PackageReader::open(char const* path) noexcept {
+  close();
+  if (!mFile->open(path)) {
+    LOG(ERROR) << "Unable to map package " << path;
+    return false;
+  }
+
+  uint8_t const* const base = mFile->data();
+  size_t const fileSize = mFile->size();
+  PackageHeader const* header = reinterpret_cast<PackageHeader const*>(base);
+  if (fileSize < sizeof(PackageHeader) || header->magic != kPackageMagic) {
+    LOG(ERROR) << "Not an engine package: " << path;
+    mFile->close();
+    return false;
+  }
+  if (header->version != kPackageVersion) {
+    LOG(ERROR) << "Unsupported package version " << header->version
+               << " (expected " << kPackageVersion << "): " << path;
+    mFile->close();
+    return false;
+  }
+  uint64_t const tocSize =
+      static_cast<uint64_t>(header->chunkCount) * sizeof(ChunkEntry);
+  if (header->fileSize != fileSize || header->tocOffset % 8 != 0 ||
+      header->tocOffset > fileSize || tocSize > fileSize - header->tocOffset) {
+    LOG(ERROR) << "Truncated or corrupt package: " << path;
+    mFile->close();
+    return false;
+  }
+
+  ChunkEntry const* entries =
+      reinterpret_cast<ChunkEntry const*>(base + header->tocOffset);
+  for (uint32_t i = 0; i < header->chunkCount; ++i) {
+    ChunkEntry const& entry = entries[i];
+    if (entry.offset % kChunkAlignment != 0 ||
+        entry.offset > header->tocOffset ||
+        entry.storedSize > header->tocOffset - entry.offset) {
+      LOG(ERROR) << "Chunk " << i << " is out of bounds: " << path;
+      mFile->close();
+      return false;
+    }
+    // Uncompressed chunks are read in place using entry.size.
+    if (entry.compression == Compression::NONE &&
+        entry.size != entry.storedSize) {
+      LOG(ERROR) << "Chunk " << i << " is stored uncompressed but its size "
+                 << entry.size << " differs from the stored size "
+                 << entry.storedSize << ": " << path;
+      mFile->close();
+      return false;
+    }
+    if (!isCompressionSupported(entry.compression)) {
+      LOG(ERROR) << "Chunk " << i << " uses unsupported compression "
+                 << static_cast<uint32_t>(entry.compression) << ": " << path;
+      mFile->close();
+      return false;
+    }
+  }
+
+  mEntries = entries;
+  mChunkCount = header->chunkCount;
+  return true;
+}
+
+void PackageReader::close() noexcept {
+  mFile->close();
+  mEntries = nullptr;
+  mChunkCount = 0;
+}
+
+bool PackageReader::isOpen() const noexcept { return mEntries != nullptr; }
+
+uint32_t PackageReader::getChunkCount() const noexcept { return mChunkCount; }
+
+ChunkEntry const& PackageReader::getChunk(uint32_t index) const noexcept {
+  DCHECK(index < mChunkCount);
+  return mEntries[index];
+}
+
+int32_t PackageReader::findChunk(ChunkType type,
+                                 char const* name) const noexcept {
+  for (uint32_t i = 0; i < mChunkCount; ++i) {
+    if (mEntries[i].type == type &&
+        !strncmp(mEntries[i].name, name, kChunkNameLength)) {
+      return static_cast<int32_t>(i);
+    }
+  }
+  return -1;
+}
+
+uint8_t const* PackageReader::getChunkData(uint32_t index) const noexcept {
+  ChunkEntry const& entry = getChunk(index);
+  if (entry.compression != Compression::NONE) {
+    return nullptr;
+  }
+  return mFile->data() + entry.offset;
+}
+
+bool PackageReader::readChunkRange(uint32_t index, uint64_t offset,
+                                   uint64_t size, void* dst) const noexcept {
+  ChunkEntry const& entry = getChunk(index);
+  if (offset > entry.size || size > entry.size - offset) {
+    return false;
+  }
+  if (entry.compression != Compression::NONE) {
+    if (offset != 0 || size != entry.size) {
+      return false;
+    }
+    return readChunk(index, dst);
+  }
+  memcpy(dst, mFile->data() + entry.offset + offset, size);
+  return true;
+}
+
+bool PackageReader::readChunk(uint32_t index, void* dst) const noexcept {
+  ChunkEntry const& entry = getChunk(index);
+  return decompress(entry.compression, mFile->data() + entry.offset,
+                    entry.storedSize, dst, entry.size);
+}
+
+bool PackageReader::readChunks(ReadRequest const* requests, size_t count,
+                               uint32_t threadCount) const noexcept {
+  for (size_t i = 0; i < count; ++i) {
+    ChunkEntry const& entry = getChunk(requests[i].chunk);
+    mFile->prefetch(entry.offset, entry.storedSize);
+  }
+
+  if (threadCount == 0) {
+    threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  threadCount = static_cast<uint32_t>(
+      std::min<size_t>(threadCount, count));
+
+  std::atomic<size_t> next{0};
+  std::atomic<bool> ok{true};
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) {
+      if (!readChunk(requests[i].chunk, requests[i].dst)) {
+        LOG(ERROR) << "Unable to read chunk " << requests[i].chunk;
+        ok = false;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount > 0 ? threadCount - 1 : 0);
+  for (uint32_t i = 1; i < threadCount; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return ok;
+}
+
+}  // namespace engine::package
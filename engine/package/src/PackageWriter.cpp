@@ -0,0 +1,151 @@
+#include "package/PackageWriter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Compression.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+
+namespace engine::package {
+
+namespace {
+
+constexpr uint8_t kPadding[kChunkAlignment] = {};
+
+inline uint64_t alignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}  // anonymous namespace
+
+uint32_t PackageWriter::addVertexBuffer(char const* name,
+                                        VertexBufferDesc const& desc,
+                                        void const* data, size_t size,
+                                        Compression compression) {
+  CHECK(size == static_cast<size_t>(desc.vertexCount) * desc.stride)
+      << "Vertex data does not match its descriptor: " << name;
+  return addChunk(ChunkType::VERTEX_BUFFER, name, &desc, sizeof(desc), data,
+                  size, compression);
+}
+
+uint32_t PackageWriter::addIndexBuffer(char const* name,
+                                       IndexBufferDesc const& desc,
+                                       void const* data, size_t size,
+                                       Compression compression) {
+  size_t const indexSize = desc.indexType == IndexType::UINT16 ? 2 : 4;
+  CHECK(size == desc.indexCount * indexSize)
+      << "Index data does not match its descriptor: " << name;
+  return addChunk(ChunkType::INDEX_BUFFER, name, &desc, sizeof(desc), data,
+                  size, compression);
+}
+
+uint32_t PackageWriter::addTexture(char const* name, TextureDesc const& desc,
+                                   void const* data, size_t size,
+                                   Compression compression) {
+  CHECK(size == getMipOffset(desc, 0) + getMipSize(desc, 0))
+      << "Texture data does not match its descriptor: " << name;
+  return addChunk(ChunkType::TEXTURE, name, &desc, sizeof(desc), data, size,
+                  compression);
+}
+
+uint32_t PackageWriter::addMeshlets(char const* name,
+                                    MeshletsDesc const& desc,
+                                    void const* data, size_t size,
+                                    Compression compression) {
+  return addChunk(ChunkType::MESHLETS, name, &desc, sizeof(desc), data, size,
+                  compression);
+}
+
+uint32_t PackageWriter::addBlob(char const* name, void const* data,
+                                size_t size, Compression compression) {
+  return addChunk(ChunkType::BLOB, name, nullptr, 0, data, size, compression);
+}
+
+uint32_t PackageWriter::addChunk(ChunkType type, char const* name,
+                                 void const* desc, size_t descSize,
+                                 void const* data, size_t size,
+                                 Compression compression) {
+  CHECK(strlen(name) < kChunkNameLength) << "Chunk name too long: " << name;
+
+  Chunk chunk{};
+  chunk.entry.type = type;
+  chunk.entry.size = size;
+  strncpy(chunk.entry.name, name, kChunkNameLength - 1);
+  if (descSize) {
+    memcpy(chunk.entry.raw, desc, descSize);
+  }
+
+  if (compression != Compression::NONE) {
+    if (!isCompressionSupported(compression)) {
+      LOG(WARNING) << "Compression " << static_cast<uint32_t>(compression)
+                   << " not available, storing " << name << " uncompressed.";
+      compression = Compression::NONE;
+    } else if (!compress(compression, data, size, chunk.payload) ||
+               chunk.payload.size() >= size) {
+      // Incompressible payloads are cheaper to load as-is.
+      compression = Compression::NONE;
+    }
+  }
+  if (compression == Compression::NONE) {
+    chunk.payload.assign(static_cast<uint8_t const*>(data),
+                         static_cast<uint8_t const*>(data) + size);
+  }
+  chunk.entry.compression = compression;
+  chunk.entry.storedSize = chunk.payload.size();
+
+  mChunks.push_back(std::move(chunk));
+  return static_cast<uint32_t>(mChunks.size() - 1);
+}
+
+uint64_t PackageWriter::getStoredSize() const noexcept {
+  uint64_t total = 0;
+  for (auto const& chunk : mChunks) {
+    total += chunk.payload.size();
+  }
+  return total;
+}
+
+bool PackageWriter::write(char const* path) const {
+  std::vector<ChunkEntry> toc;
+  toc.reserve(mChunks.size());
+
+  uint64_t offset = kChunkAlignment;
+  for (auto const& chunk : mChunks) {
+    ChunkEntry entry = chunk.entry;
+    entry.offset = offset;
+    toc.push_back(entry);
+    offset = alignUp(offset + chunk.payload.size(), kChunkAlignment);
+  }
+
+  PackageHeader header{};
+  header.magic = kPackageMagic;
+  header.version = kPackageVersion;
+  header.chunkCount = static_cast<uint32_t>(toc.size());
+  header.tocOffset = offset;
+  header.fileSize = offset + toc.size() * sizeof(ChunkEntry);
+
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    LOG(ERROR) << "Unable to open " << path << " for writing.";
+    return false;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  ok = ok && fwrite(kPadding, kChunkAlignment - sizeof(header), 1, file) == 1;
+  for (auto const& chunk : mChunks) {
+    size_t const size = chunk.payload.size();
+    size_t const padding = alignUp(size, kChunkAlignment) - size;
+    ok = ok && (size == 0 ||
+                fwrite(chunk.payload.data(), size, 1, file) == 1);
+    ok = ok && (padding == 0 || fwrite(kPadding, padding, 1, file) == 1);
+  }
+  ok = ok && (toc.empty() || fwrite(toc.data(), sizeof(ChunkEntry),
+                                    toc.size(), file) == toc.size());
+  ok = (fclose(file) == 0) && ok;
+  if (!ok) {
+    LOG(ERROR) << "Failed writing package " << path;
+  }
+  return ok;
+}
+
+}  // namespace engine::package
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <vector>
+
+#include "package/PackageFormat.h"
+#include "private/backend/Driver.h"
+
+namespace engine::package {
+class PackageReader;
+}
+
+namespace engine::streaming {
+
+using StreamedTextureId = uint32_t;
+
+constexpr StreamedTextureId INVALID_STREAMED_TEXTURE = UINT32_MAX;
+
+struct StreamingConfig {
+  // Hard cap on the texel bytes of streamed textures. 0 derives the cap from
+  // the device memory budget instead.
+  uint64_t budgetBytes = 0;
+  // Share of the device budget the streamer may fill, after subtracting
+  // what the rest of the process already uses.
+  float budgetFraction = 0.8f;
+  // Cap used when budgetBytes is 0 and the device reports no budget.
+  uint64_t fallbackBudgetBytes = 256ull * 1024 * 1024;
+  // Transfer bandwidth, in texel bytes per update(). Covers both the
+  // levels uploaded and the levels copied over when a texture is replaced.
+  uint64_t transferBytesPerFrame = 8ull * 1024 * 1024;
+  // Levels whose larger edge is at most this many texels make up the mip
+  // tail. The tail is loaded when a texture is added and never evicted.
+  uint32_t tailSize = 128;
+  // Frames without usage reports after which a texture no longer asks for
+  // more than its tail.
+  uint32_t demandTimeoutFrames = 60;
+};
+
+struct StreamingStats {
+  uint64_t budgetBytes = 0;
+  uint64_t residentBytes = 0;
+  // Replaced driver textures the GPU may still be using. They stay
+  // allocated, and count against the budget, until it is done with them.
+  uint64_t retiringBytes = 0;
+  // Bytes that would be resident if every demand were met.
+  uint64_t demandedBytes = 0;
+  uint64_t uploadedBytes = 0;  // during the last update()
+  uint64_t evictedBytes = 0;   // during the last update()
+  // Levels copied from a replaced texture into its successor, during the
+  // last update(). Stream-ins and evictions both pay for these.
+  uint64_t copiedBytes = 0;
+  uint64_t totalUploadedBytes = 0;
+  uint64_t totalCopiedBytes = 0;
+  uint64_t totalEvictedBytes = 0;
+  uint32_t textureCount = 0;
+  // Textures whose finest demanded level is resident.
+  uint32_t texturesAtTarget = 0;
+};
+
+// Keeps the mip chains of package textures partially resident. Each
+// texture always holds its mip tail; finer levels are streamed in by
+// screen-space demand and evicted least recently used first whenever the
+// resident set exceeds the budget.
+//
+// A texture with resident level r is a driver texture holding levels
+// [r, levels) of the source, so the handle returned by getTexture()
+// changes whenever the residency does.
+class TextureStreamer {
+ public:
+  TextureStreamer(backend::Driver* driver,
+                  StreamingConfig const& config = {}) noexcept;
+  ~TextureStreamer() noexcept;
+
+  TextureStreamer(TextureStreamer const&) = delete;
+  TextureStreamer& operator=(TextureStreamer const&) = delete;
+
+  // Registers a TEXTURE chunk and uploads its mip tail. The package must
+  // stay open until the texture is removed. Returns INVALID_STREAMED_TEXTURE
+  // if the chunk is not a texture the driver can create.
+  StreamedTextureId addTexture(package::PackageReader const& package,
+                               uint32_t chunk);
+
+  void removeTexture(StreamedTextureId id);
+
+  // Feedback for the current frame: the texture is drawn covering
+  // |screenSize| pixels along its larger edge. Several reports in one frame
+  // keep the largest.
+  void reportUsage(StreamedTextureId id, float screenSize) noexcept;
+
+  // Feedback for the current frame as the finest level sampled, for
+  // example from a GPU feedback buffer.
+  void reportLevel(StreamedTextureId id, uint32_t level) noexcept;
+
+  // Applies this frame's feedback, evicts down to the budget and schedules
+  // uploads and copies within the per-frame bandwidth. Call once per frame.
+  void update();
+
+  backend::TextureHandle getTexture(StreamedTextureId id) const noexcept;
+
+  // Finest level currently resident, in source level numbering.
+  uint32_t getResidentLevel(StreamedTextureId id) const noexcept;
+
+  // Finest level the feedback currently asks for.
+  uint32_t getDesiredLevel(StreamedTextureId id) const noexcept;
+
+  StreamingStats const& getStats() const noexcept { return mStats; }
+
+  // Level whose size matches |screenSize| pixels along the larger edge.
+  static uint32_t computeLevel(uint32_t width, uint32_t height,
+                               uint32_t levels, float screenSize) noexcept;
+
+ private:
+  struct Texture {
+    package::PackageReader const* package = nullptr;
+    uint32_t chunk = 0;
+    package::TextureDesc desc = {};
+    backend::TextureFormat format = backend::TextureFormat::RGBA8;
+    // Source texels for compressed chunks, smallest mip first.
+    std::vector<uint8_t> decompressed;
+    backend::TextureHandle handle;
+    uint32_t residentLevel = 0;
+    uint32_t tailLevel = 0;
+    uint32_t desiredLevel = 0;
+    // Finest level reported during the current frame.
+    uint32_t reportedLevel = UINT32_MAX;
+    float screenSize = 0.0f;
+    uint64_t lastUsedFrame = 0;
+    bool live = false;
+  };
+
+  uint8_t const* getLevelData(Texture const& texture,
+                              uint32_t level) const noexcept;
+
+  // Bytes of levels [level, levels).
+  static uint64_t getChainSize(Texture const& texture,
+                               uint32_t level) noexcept;
+
+  // Replaces the driver texture by one that starts at |level|, copying the
+  // levels both have and uploading the rest.
+  void setResidentLevel(Texture& texture, uint32_t level);
+
+  uint64_t computeBudget() const noexcept;
+
+  // Drops levels of least recently used textures until |bytes| more fit in
+  // the budget. |keep| and textures used at or after |protectFrame| are
+  // spared. Returns false if that much cannot be freed, or not before the
+  // retiring textures are.
+  bool makeRoom(uint64_t bytes, uint64_t budget, uint64_t protectFrame,
+                Texture const* keep);
+
+  // Whether makeRoom() may take levels from |texture|.
+  static bool isEvictable(Texture const& texture, uint64_t protectFrame,
+                          Texture const* keep) noexcept;
+
+  // Bytes makeRoom() could free at most with the same arguments.
+  uint64_t getEvictableBytes(uint64_t protectFrame,
+                             Texture const* keep) const noexcept;
+
+  backend::Driver* const mDriver;
+  StreamingConfig const mConfig;
+  std::vector<Texture> mTextures;
+  std::vector<StreamedTextureId> mFreeIds;
+  // Retiring bytes not yet covered by a fence, and those waiting on one.
+  struct Retiring {
+    backend::GpuFence fence;
+    uint64_t bytes = 0;
+  };
+  uint64_t mUnflushedRetiringBytes = 0;
+  std::deque<Retiring> mRetiring;
+  // Texture that evicted others to make room for |mPendingLevel|. Evicted
+  // levels stay allocated until the GPU is done with them, so it streams
+  // in on a later frame, and no other texture may evict or take the room
+  // until it has.
+  StreamedTextureId mPendingId = INVALID_STREAMED_TEXTURE;
+  uint32_t mPendingLevel = 0;
+  uint64_t mFrame = 0;
+  StreamingStats mStats;
+};
+
+}  // namespace engine::streaming
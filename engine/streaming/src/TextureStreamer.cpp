@@ -0,0 +1,491 @@
+#include "streaming/TextureStreamer.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "package/PackageReader.h"
+
+namespace engine::streaming {
+
+using namespace backend;
+using package::ChunkEntry;
+using package::ChunkType;
+using package::Compression;
+using package::PixelFormat;
+
+namespace {
+
+bool getTextureFormat(PixelFormat format, TextureFormat* out) noexcept {
+  switch (format) {
+    case PixelFormat::R8_UNORM:
+      *out = TextureFormat::R8;
+      return true;
+    case PixelFormat::RG8_UNORM:
+      *out = TextureFormat::RG8;
+      return true;
+    case PixelFormat::RGBA8_UNORM:
+      *out = TextureFormat::RGBA8;
+      return true;
+    case PixelFormat::RGBA8_SRGB:
+      *out = TextureFormat::RGBA8_SRGB;
+      return true;
+    case PixelFormat::RGBA16_FLOAT:
+      *out = TextureFormat::RGBA16F;
+      return true;
+    case PixelFormat::RGBA32_FLOAT:
+      *out = TextureFormat::RGBA32F;
+      return true;
+    case PixelFormat::BC1_UNORM:
+      *out = TextureFormat::BC1_RGBA;
+      return true;
+    case PixelFormat::BC3_UNORM:
+      *out = TextureFormat::BC3_RGBA;
+      return true;
+    case PixelFormat::BC7_UNORM:
+      *out = TextureFormat::BC7_RGBA;
+      return true;
+  }
+  return false;
+}
+
+inline uint32_t getEdge(package::TextureDesc const& desc, uint32_t level) {
+  return std::max(std::max(desc.width, desc.height) >> level, 1u);
+}
+
+}  // anonymous namespace
+
+TextureStreamer::TextureStreamer(Driver* driver,
+                                 StreamingConfig const& config) noexcept
+    : mDriver(driver), mConfig(config) {}
+
+TextureStreamer::~TextureStreamer() noexcept {
+  for (Texture& texture : mTextures) {
+    if (texture.live) {
+      mDriver->destroyTexture(texture.handle);
+    }
+  }
+}
+
+StreamedTextureId TextureStreamer::addTexture(
+    package::PackageReader const& package, uint32_t chunk) {
+  ChunkEntry const& entry = package.getChunk(chunk);
+  TextureFormat format;
+  if (entry.type != ChunkType::TEXTURE ||
+      !getTextureFormat(entry.texture.format, &format)) {
+    LOG(ERROR) << "Chunk " << chunk << " is not a streamable texture.";
+    return INVALID_STREAMED_TEXTURE;
+  }
+  if (entry.texture.levels == 0 || entry.texture.levels > UINT8_MAX) {
+    LOG(ERROR) << "Texture '" << entry.name << "' has "
+               << entry.texture.levels << " levels.";
+    return INVALID_STREAMED_TEXTURE;
+  }
+
+  StreamedTextureId id;
+  if (!mFreeIds.empty()) {
+    id = mFreeIds.back();
+    mFreeIds.pop_back();
+  } else {
+    id = static_cast<StreamedTextureId>(mTextures.size());
+    mTextures.emplace_back();
+  }
+
+  Texture& texture = mTextures[id];
+  texture.package = &package;
+  texture.chunk = chunk;
+  texture.desc = entry.texture;
+  texture.format = format;
+  if (entry.compression != Compression::NONE) {
+    // Compressed chunks can only be read whole, so keep a decompressed copy
+    // to stream levels from.
+    texture.decompressed.resize(entry.size);
+    if (!package.readChunk(chunk, texture.decompressed.data())) {
+      LOG(ERROR) << "Unable to decompress texture '" << entry.name << "'.";
+      texture = Texture{};
+      mFreeIds.push_back(id);
+      return INVALID_STREAMED_TEXTURE;
+    }
+  }
+
+  uint32_t tailLevel = 0;
+  while (tailLevel + 1 < texture.desc.levels &&
+         getEdge(texture.desc, tailLevel) > mConfig.tailSize) {
+    tailLevel++;
+  }
+  texture.tailLevel = tailLevel;
+  texture.desiredLevel = tailLevel;
+  texture.lastUsedFrame = mFrame;
+  texture.live = true;
+  setResidentLevel(texture, tailLevel);
+  mStats.textureCount++;
+  return id;
+}
+
+void TextureStreamer::removeTexture(StreamedTextureId id) {
+  if (id >= mTextures.size() || !mTextures[id].live) {
+    return;
+  }
+  Texture& texture = mTextures[id];
+  mDriver->destroyTexture(texture.handle);
+  uint64_t const chain = getChainSize(texture, texture.residentLevel);
+  mStats.residentBytes -= chain;
+  mStats.retiringBytes += chain;
+  mUnflushedRetiringBytes += chain;
+  mStats.textureCount--;
+  if (mPendingId == id) {
+    mPendingId = INVALID_STREAMED_TEXTURE;
+  }
+  texture = Texture{};
+  mFreeIds.push_back(id);
+}
+
+void TextureStreamer::reportUsage(StreamedTextureId id,
+                                  float screenSize) noexcept {
+  if (id >= mTextures.size() || !mTextures[id].live) {
+    return;
+  }
+  Texture& texture = mTextures[id];
+  uint32_t const level = computeLevel(texture.desc.width, texture.desc.height,
+                                      texture.desc.levels, screenSize);
+  if (texture.reportedLevel == UINT32_MAX) {
+    texture.screenSize = 0.0f;
+  }
+  texture.screenSize = std::max(texture.screenSize, screenSize);
+  texture.reportedLevel = std::min(texture.reportedLevel, level);
+}
+
+void TextureStreamer::reportLevel(StreamedTextureId id,
+                                  uint32_t level) noexcept {
+  if (id >= mTextures.size() || !mTextures[id].live) {
+    return;
+  }
+  Texture& texture = mTextures[id];
+  level = std::min(level, texture.desc.levels - 1);
+  if (texture.reportedLevel == UINT32_MAX) {
+    texture.screenSize = 0.0f;
+  }
+  texture.screenSize = std::max(texture.screenSize,
+                                float(getEdge(texture.desc, level)));
+  texture.reportedLevel = std::min(texture.reportedLevel, level);
+}
+
+void TextureStreamer::update() {
+  mStats.uploadedBytes = 0;
+  mStats.evictedBytes = 0;
+  mStats.copiedBytes = 0;
+  while (!mRetiring.empty() && mDriver->isSignaled(mRetiring.front().fence)) {
+    mStats.retiringBytes -= mRetiring.front().bytes;
+    mRetiring.pop_front();
+  }
+  uint64_t const budget = computeBudget();
+  mStats.budgetBytes = budget;
+
+  // Turn this frame's feedback into demand.
+  for (Texture& texture : mTextures) {
+    if (!texture.live) {
+      continue;
+    }
+    if (texture.reportedLevel != UINT32_MAX) {
+      texture.desiredLevel = std::min(texture.reportedLevel, texture.tailLevel);
+      texture.lastUsedFrame = mFrame;
+    } else if (mFrame - texture.lastUsedFrame > mConfig.demandTimeoutFrames) {
+      texture.desiredLevel = texture.tailLevel;
+      texture.screenSize = 0.0f;
+    }
+    texture.reportedLevel = UINT32_MAX;
+  }
+
+  // The budget may have shrunk since the last frame.
+  if (mStats.residentBytes > budget) {
+    makeRoom(0, budget, UINT64_MAX, nullptr);
+  }
+
+  // The pending stream-in may no longer be wanted.
+  Texture* pending = nullptr;
+  if (mPendingId != INVALID_STREAMED_TEXTURE) {
+    pending = &mTextures[mPendingId];
+    if (pending->desiredLevel >= pending->residentLevel) {
+      pending = nullptr;
+      mPendingId = INVALID_STREAMED_TEXTURE;
+    }
+  }
+
+  // Stream in the texture that made room for itself first, then those that
+  // are most magnified on screen.
+  std::vector<Texture*> candidates;
+  for (Texture& texture : mTextures) {
+    if (texture.live && texture.desiredLevel < texture.residentLevel) {
+      candidates.push_back(&texture);
+    }
+  }
+  auto magnification = [](Texture const* texture) {
+    return texture->screenSize /
+           float(getEdge(texture->desc, texture->residentLevel));
+  };
+  std::sort(candidates.begin(), candidates.end(),
+            [&](Texture const* a, Texture const* b) {
+              if ((a == pending) != (b == pending)) {
+                return a == pending;
+              }
+              return magnification(a) > magnification(b);
+            });
+
+  for (Texture* texture : candidates) {
+    uint64_t const transferred = mStats.uploadedBytes + mStats.copiedBytes;
+    uint64_t const transferBudget = mConfig.transferBytesPerFrame > transferred
+                                        ? mConfig.transferBytesPerFrame -
+                                              transferred
+                                        : 0;
+    // The new chain is written in full: the levels the texture lacks are
+    // uploaded and the rest copied from the old driver texture. Go as far
+    // toward the demand as the bandwidth allows, but always at least one
+    // level so that levels larger than the per-frame bandwidth still stream
+    // in, one per frame. The pending texture goes for the level it made room
+    // for.
+    uint32_t level = texture->residentLevel - 1;
+    if (texture == pending) {
+      level = std::max(mPendingLevel, texture->desiredLevel);
+    } else {
+      while (level > texture->desiredLevel &&
+             getChainSize(*texture, level - 1) <= transferBudget) {
+        level--;
+      }
+    }
+    // The new chain is allocated in full while the old one is still alive,
+    // so all of it has to fit, next to whatever is still retiring.
+    uint64_t const peak = getChainSize(*texture, level);
+    if (peak > transferBudget && transferred > 0) {
+      break;
+    }
+    if (mStats.residentBytes + mStats.retiringBytes + peak <= budget) {
+      setResidentLevel(*texture, level);
+      if (texture == pending) {
+        pending = nullptr;
+        mPendingId = INVALID_STREAMED_TEXTURE;
+      }
+      continue;
+    }
+    if (texture == pending) {
+      if (mStats.retiringBytes > 0) {
+        // Keep the room it evicted for until the GPU gives it back.
+        break;
+      }
+      // The room went elsewhere, as when the budget shrank; start over.
+      pending = nullptr;
+      mPendingId = INVALID_STREAMED_TEXTURE;
+    }
+    // Only retiring textures are in the way, and they come back on their
+    // own. Evicting is also pointless when it cannot free enough, or when
+    // another texture already waits for the room it evicted.
+    if (mStats.residentBytes + peak <= budget ||
+        mStats.residentBytes + peak >
+            budget + getEvictableBytes(mFrame, texture) ||
+        mPendingId != INVALID_STREAMED_TEXTURE) {
+      continue;
+    }
+    // Evicted levels stay allocated until the GPU is done with them, so the
+    // stream-in never fits in the frame that evicts for it. Hold the room
+    // for this texture and retry it first on the next frames.
+    makeRoom(peak, budget, mFrame, texture);
+    mPendingId = static_cast<StreamedTextureId>(texture - mTextures.data());
+    mPendingLevel = level;
+  }
+
+  mStats.demandedBytes = 0;
+  mStats.texturesAtTarget = 0;
+  for (Texture const& texture : mTextures) {
+    if (texture.live) {
+      mStats.demandedBytes += getChainSize(texture, texture.desiredLevel);
+      if (texture.residentLevel <= texture.desiredLevel) {
+        mStats.texturesAtTarget++;
+      }
+    }
+  }
+
+  if (mStats.uploadedBytes || mStats.copiedBytes ||
+      mUnflushedRetiringBytes) {
+    GpuFence const fence = mDriver->flush();
+    if (mUnflushedRetiringBytes) {
+      mRetiring.push_back({fence, mUnflushedRetiringBytes});
+      mUnflushedRetiringBytes = 0;
+    }
+  }
+  mFrame++;
+}
+
+TextureHandle TextureStreamer::getTexture(
+    StreamedTextureId id) const noexcept {
+  return id < mTextures.size() ? mTextures[id].handle : TextureHandle{};
+}
+
+uint32_t TextureStreamer::getResidentLevel(
+    StreamedTextureId id) const noexcept {
+  return id < mTextures.size() ? mTextures[id].residentLevel : 0;
+}
+
+uint32_t TextureStreamer::getDesiredLevel(
+    StreamedTextureId id) const noexcept {
+  return id < mTextures.size() ? mTextures[id].desiredLevel : 0;
+}
+
+uint32_t TextureStreamer::computeLevel(uint32_t width, uint32_t height,
+                                       uint32_t levels,
+                                       float screenSize) noexcept {
+  if (screenSize < 1.0f) {
+    return levels - 1;
+  }
+  // The finest level needed is the smallest one still at least as large as
+  // the footprint on screen.
+  float const ratio = float(std::max(width, height)) / screenSize;
+  if (ratio <= 1.0f) {
+    return 0;
+  }
+  uint32_t const level = static_cast<uint32_t>(floorf(log2f(ratio)));
+  return std::min(level, levels - 1);
+}
+
+uint8_t const* TextureStreamer::getLevelData(Texture const& texture,
+                                             uint32_t level) const noexcept {
+  uint8_t const* data = texture.decompressed.empty()
+                            ? texture.package->getChunkData(texture.chunk)
+                            : texture.decompressed.data();
+  return data + package::getMipOffset(texture.desc, level);
+}
+
+uint64_t TextureStreamer::getChainSize(Texture const& texture,
+                                       uint32_t level) noexcept {
+  // Levels are stored smallest first, so [level, levels) is a prefix.
+  return package::getMipOffset(texture.desc, level) +
+         package::getMipSize(texture.desc, level);
+}
+
+void TextureStreamer::setResidentLevel(Texture& texture, uint32_t level) {
+  package::TextureDesc const& desc = texture.desc;
+  uint32_t const width = std::max(desc.width >> level, 1u);
+  uint32_t const height = std::max(desc.height >> level, 1u);
+  TextureHandle const handle = mDriver->createTexture(
+      texture.format, width, height, uint8_t(desc.levels - level),
+      TextureUsage::SAMPLEABLE | TextureUsage::UPLOADABLE);
+
+  for (uint32_t source = level; source < desc.levels; ++source) {
+    uint8_t const dstLevel = uint8_t(source - level);
+    if (texture.handle && source >= texture.residentLevel) {
+      mDriver->copyTexture(handle, dstLevel, texture.handle,
+                           uint8_t(source - texture.residentLevel));
+      uint64_t const size = package::getMipSize(desc, source);
+      mStats.copiedBytes += size;
+      mStats.totalCopiedBytes += size;
+    } else {
+      uint64_t const size = package::getMipSize(desc, source);
+      mDriver->updateTexture(handle, dstLevel, getLevelData(texture, source),
+                             size);
+      mStats.uploadedBytes += size;
+      mStats.totalUploadedBytes += size;
+    }
+  }
+
+  if (texture.handle) {
+    mDriver->destroyTexture(texture.handle);
+    uint64_t const chain = getChainSize(texture, texture.residentLevel);
+    mStats.residentBytes -= chain;
+    mStats.retiringBytes += chain;
+    mUnflushedRetiringBytes += chain;
+  }
+  mStats.residentBytes += getChainSize(texture, level);
+  texture.handle = handle;
+  texture.residentLevel = level;
+}
+
+uint64_t TextureStreamer::computeBudget() const noexcept {
+  if (mConfig.budgetBytes) {
+    return mConfig.budgetBytes;
+  }
+  MemoryBudget const device = mDriver->getMemoryBudget();
+  if (!device.budget) {
+    return mConfig.fallbackBudgetBytes;
+  }
+  // Whatever the rest of the process uses is not ours to take.
+  uint64_t const ours = mStats.residentBytes + mStats.retiringBytes;
+  uint64_t const others = device.usage > ours ? device.usage - ours : 0;
+  uint64_t const share =
+      static_cast<uint64_t>(double(device.budget) * mConfig.budgetFraction);
+  return share > others ? share - others : 0;
+}
+
+bool TextureStreamer::makeRoom(uint64_t bytes, uint64_t budget,
+                               uint64_t protectFrame, Texture const* keep) {
+  while (mStats.residentBytes + bytes > budget) {
+    // Textures holding more than they are asked for go first, then the
+    // least recently used.
+    Texture* victim = nullptr;
+    for (Texture& texture : mTextures) {
+      if (!isEvictable(texture, protectFrame, keep)) {
+        continue;
+      }
+      if (!victim) {
+        victim = &texture;
+        continue;
+      }
+      bool const excess = texture.residentLevel < texture.desiredLevel;
+      bool const victimExcess = victim->residentLevel < victim->desiredLevel;
+      if (excess != victimExcess) {
+        if (excess) {
+          victim = &texture;
+        }
+      } else if (texture.lastUsedFrame < victim->lastUsedFrame) {
+        victim = &texture;
+      }
+    }
+    if (!victim) {
+      return false;
+    }
+
+    uint32_t level = victim->residentLevel < victim->desiredLevel
+                         ? victim->desiredLevel
+                         : victim->residentLevel + 1;
+    // The reduced chain is allocated before the old one is freed. Evict
+    // further when the headroom cannot hold it, and wait for the retiring
+    // textures when not even the tail fits. Past the budget already, as
+    // when it shrank, go straight to the tail.
+    uint64_t const footprint = mStats.residentBytes + mStats.retiringBytes;
+    while (level < victim->tailLevel &&
+           footprint + getChainSize(*victim, level) > budget) {
+      level++;
+    }
+    if (footprint <= budget &&
+        footprint + getChainSize(*victim, level) > budget) {
+      return false;
+    }
+    uint64_t const freed = getChainSize(*victim, victim->residentLevel) -
+                           getChainSize(*victim, level);
+    mStats.evictedBytes += freed;
+    mStats.totalEvictedBytes += freed;
+    setResidentLevel(*victim, level);
+  }
+  return true;
+}
+
+bool TextureStreamer::isEvictable(Texture const& texture,
+                                  uint64_t protectFrame,
+                                  Texture const* keep) noexcept {
+  return texture.live && &texture != keep &&
+         texture.residentLevel < texture.tailLevel &&
+         texture.lastUsedFrame < protectFrame;
+}
+
+uint64_t TextureStreamer::getEvictableBytes(
+    uint64_t protectFrame, Texture const* keep) const noexcept {
+  uint64_t bytes = 0;
+  for (Texture const& texture : mTextures) {
+    if (isEvictable(texture, protectFrame, keep)) {
+      bytes += getChainSize(texture, texture.residentLevel) -
+               getChainSize(texture, texture.tailLevel);
+    }
+  }
+  return bytes;
+}
+
+}  // namespace engine::streaming
@@ -0,0 +1,213 @@
+// Measures clustered light culling on the CPU and on the GPU and checks that
+// both produce the same light lists.
+//
+// Point lights are scattered through the view frustum, evenly per depth
+// slice, and binned into a 16x9x64 grid, first by the CPU reference and then
+// by the compute build. Every cluster's list from the GPU must be sorted and
+// hold the same lights as the CPU one; only lights lying on a cluster
+// boundary within float rounding may differ. The scene is sized so that
+// even the densest cluster at 50k lights stays under MAX_LIGHTS_PER_CLUSTER;
+// a cluster that hits the cap would shade with lights missing, so any
+// capped cluster fails the run.
+//
+// Usage: cluster_bench [iterations]
+//
+// Runs headless, so a software device works too, e.g.
+//   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json cluster_bench
+
+#include <backend/Platform.h>
+#include <lighting/ClusterBuilder.h>
+#include <lighting/ClusterGrid.h>
+#include <math.h>
+#include <private/backend/Driver.h>
+#include <private/backend/PlatformFactory.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <random>
+#include <vector>
+
+using namespace engine::backend;
+using namespace engine::lighting;
+
+namespace {
+
+constexpr uint32_t LIGHT_COUNTS[] = {1000, 10000, 50000};
+// Thinner slices than the default keep the cluster boxes close to the
+// frustum, so fewer lights touch each one.
+constexpr uint32_t GRID_Z = 64;
+constexpr float NEAR_PLANE = 1.0f;
+constexpr float MIN_DEPTH = 10.0f;
+constexpr float MAX_DEPTH = 400.0f;
+constexpr float MIN_RADIUS = 0.5f;
+constexpr float MAX_RADIUS = 1.5f;
+// Relative slack of the boundary test when the two paths disagree.
+constexpr float BORDER_TOLERANCE = 1e-3f;
+
+using Clock = std::chrono::steady_clock;
+
+double getMilliseconds(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+std::vector<PointLight> makeLights(ClusterConfig const& config,
+                                   uint32_t count) {
+  std::mt19937 random(count);
+  std::uniform_real_distribution<float> ndc(-1.0f, 1.0f);
+  // Uniform in log depth, like the slices.
+  std::uniform_real_distribution<float> logDepth(logf(MIN_DEPTH),
+                                                 logf(MAX_DEPTH));
+  std::uniform_real_distribution<float> radius(MIN_RADIUS, MAX_RADIUS);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  float const tanHalfFovY = tanf(0.5f * config.fovY);
+  std::vector<PointLight> lights(count);
+  for (PointLight& light : lights) {
+    float const z = expf(logDepth(random));
+    light.position[0] = ndc(random) * z * tanHalfFovY * config.aspect;
+    light.position[1] = ndc(random) * z * tanHalfFovY;
+    light.position[2] = -z;
+    light.radius = radius(random);
+    for (float& channel : light.color) {
+      channel = unit(random);
+    }
+    light.intensity = 1.0f;
+  }
+  return lights;
+}
+
+// Whether |light| touches the cluster box only within float rounding.
+bool isBorderline(ClusterGrid const& grid, uint32_t cluster,
+                  PointLight const& light) {
+  ClusterConfig const& config = grid.getConfig();
+  uint32_t const x = cluster % config.gridX;
+  uint32_t const y = cluster / config.gridX % config.gridY;
+  uint32_t const z = cluster / (config.gridX * config.gridY);
+  float min[3];
+  float max[3];
+  grid.getBounds(x, y, z, min, max);
+  float distance2 = 0.0f;
+  for (int i = 0; i < 3; ++i) {
+    float const delta =
+        std::clamp(light.position[i], min[i], max[i]) - light.position[i];
+    distance2 += delta * delta;
+  }
+  float const slack =
+      BORDER_TOLERANCE * std::max(light.radius, -light.position[2]);
+  return fabsf(sqrtf(distance2) - light.radius) <= slack;
+}
+
+// Returns the number of clusters whose lists do not match.
+uint32_t compare(ClusterGrid const& grid,
+                 std::vector<PointLight> const& lights,
+                 std::vector<ClusterRange> const& cpuRanges,
+                 std::vector<uint32_t> const& cpuIndices,
+                 std::vector<ClusterRange> const& gpuRanges,
+                 std::vector<uint32_t> const& gpuIndices) {
+  uint32_t mismatches = 0;
+  std::vector<uint32_t> expected;
+  std::vector<uint32_t> actual;
+  std::vector<uint32_t> difference;
+  for (uint32_t cluster = 0; cluster < grid.getClusterCount(); ++cluster) {
+    ClusterRange const& cpu = cpuRanges[cluster];
+    ClusterRange const& gpu = gpuRanges[cluster];
+    if (gpu.offset + gpu.count > gpuIndices.size()) {
+      mismatches++;
+      continue;
+    }
+    expected.assign(cpuIndices.begin() + cpu.offset,
+                    cpuIndices.begin() + cpu.offset + cpu.count);
+    actual.assign(gpuIndices.begin() + gpu.offset,
+                  gpuIndices.begin() + gpu.offset + gpu.count);
+    if (!std::is_sorted(actual.begin(), actual.end())) {
+      mismatches++;
+      continue;
+    }
+    difference.clear();
+    std::set_symmetric_difference(expected.begin(), expected.end(),
+                                  actual.begin(), actual.end(),
+                                  std::back_inserter(difference));
+    for (uint32_t light : difference) {
+      if (light >= lights.size() ||
+          !isBorderline(grid, cluster, lights[light])) {
+        mismatches++;
+        break;
+      }
+    }
+  }
+  return mismatches;
+}
+
+// Benchmarks and validates every light count; returns whether all passed.
+bool run(Driver* driver, uint32_t iterations) {
+  ClusterConfig config;
+  config.gridZ = GRID_Z;
+  config.nearPlane = NEAR_PLANE;
+  // The densest scene lists more than the default average per cluster;
+  // leave room for every cluster to be full.
+  config.averageLightsPerCluster = MAX_LIGHTS_PER_CLUSTER;
+  ClusterGrid const grid(config);
+  ClusterBuilder builder(driver, config);
+
+  printf("%u clusters, %u iterations\n", grid.getClusterCount(), iterations);
+  printf("%8s %10s %10s %12s %8s %10s\n", "lights", "cpu", "gpu", "indices",
+         "capped", "mismatch");
+  bool passed = true;
+  std::vector<ClusterRange> cpuRanges;
+  std::vector<uint32_t> cpuIndices;
+  std::vector<ClusterRange> gpuRanges;
+  std::vector<uint32_t> gpuIndices;
+  for (uint32_t lightCount : LIGHT_COUNTS) {
+    std::vector<PointLight> const lights = makeLights(config, lightCount);
+
+    auto start = Clock::now();
+    uint32_t cpuCapped = 0;
+    for (uint32_t i = 0; i < iterations; ++i) {
+      cpuCapped = buildClusters(grid, lights.data(), lightCount, cpuRanges,
+                                cpuIndices);
+    }
+    double const cpuMs = getMilliseconds(start) / iterations;
+
+    // Includes the upload of the lights, as a frame would. The first build
+    // grows the lights buffer and is left out.
+    driver->wait(builder.build(lights.data(), lightCount), UINT64_MAX);
+    start = Clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+      driver->wait(builder.build(lights.data(), lightCount), UINT64_MAX);
+    }
+    double const gpuMs = getMilliseconds(start) / iterations;
+
+    uint32_t gpuCapped = 0;
+    bool const complete =
+        builder.readBack(gpuRanges, gpuIndices, &gpuCapped);
+    uint32_t const mismatches = compare(grid, lights, cpuRanges, cpuIndices,
+                                        gpuRanges, gpuIndices);
+    printf("%8u %8.3fms %8.3fms %12zu %8u %10u%s\n", lightCount, cpuMs,
+           gpuMs, gpuIndices.size(), gpuCapped, mismatches,
+           complete ? "" : "  (index buffer overflow)");
+    if (gpuCapped != cpuCapped) {
+      printf("%8s CPU capped %u clusters\n", "", cpuCapped);
+    }
+    passed = passed && complete && mismatches == 0 && gpuCapped == 0 &&
+             cpuCapped == 0;
+  }
+  return passed;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  uint32_t const iterations = argc > 1 ? std::max(atoi(argv[1]), 1) : 20;
+
+  Platform* platform = PlatformFactory::create();
+  Driver* driver = platform->createDriver();
+  bool const passed = run(driver, iterations);
+  driver->terminate();
+  PlatformFactory::destroy(&platform);
+
+  printf("%s\n", passed ? "PASSED" : "FAILED");
+  return passed ? 0 : 1;
+}
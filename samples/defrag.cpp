@@ -0,0 +1,249 @@
+// Fragments device memory the way a long session does, by creating many
+// buffers and textures and destroying most of them in random order, then
+// compacts it with Driver::defragment() under a per-frame copy budget.
+//
+// Prints the fragmentation before and after and the bytes moved each frame.
+// Fails unless memory ends up in fewer blocks or less fragmented, or if any
+// surviving resource, down to every mip level, lost its contents.
+//
+// Usage: defrag [budget MB per frame]
+
+#include <backend/Platform.h>
+#include <private/backend/Driver.h>
+#include <private/backend/PlatformFactory.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace engine::backend;
+
+namespace {
+
+constexpr uint32_t BUFFER_COUNT = 1536;
+constexpr uint32_t TEXTURE_COUNT = 256;
+constexpr uint32_t MIN_BUFFER_SIZE = 16 * 1024;
+constexpr uint32_t MAX_BUFFER_SIZE = 512 * 1024;
+constexpr uint32_t MIN_TEXTURE_SIZE = 32;
+constexpr uint32_t MAX_TEXTURE_SIZE = 256;
+// Share of the resources destroyed to fragment memory.
+constexpr float DESTROY_RATIO = 0.75f;
+constexpr uint32_t MAX_FRAMES = 1000;
+// Waits in a row with nothing to move before the blocks count as stuck.
+constexpr uint32_t MAX_IDLE_WAITS = 4;
+
+constexpr double MB = 1024.0 * 1024.0;
+
+struct Buffer {
+  BufferObjectHandle handle;
+  std::vector<uint8_t> contents;
+};
+
+struct Texture {
+  TextureHandle handle;
+  uint32_t size;
+  // One entry per mip level.
+  std::vector<std::vector<uint8_t>> contents;
+};
+
+std::vector<uint8_t> makeContents(size_t size, uint32_t seed) {
+  std::vector<uint8_t> contents(size);
+  for (size_t i = 0; i < size; ++i) {
+    contents[i] = static_cast<uint8_t>(i * 31 + seed * 17 + (i >> 9));
+  }
+  return contents;
+}
+
+void printFragmentation(char const* label, MemoryFragmentation const& f) {
+  printf("%-7s %4u blocks %8.1fMB held %8.1fMB used %7.1f%% occupancy "
+         "%8.2fMB largest hole %5.3f fragmentation\n",
+         label, f.blockCount, f.blockBytes / MB, f.usedBytes / MB,
+         f.blockBytes ? 100.0 * f.usedBytes / f.blockBytes : 0.0,
+         f.largestFreeRange / MB, f.fragmentation);
+}
+
+bool checkBuffer(Driver* driver, Buffer const& buffer) {
+  std::vector<uint8_t> data(buffer.contents.size());
+  driver->readBufferObject(buffer.handle, data.data(),
+                           static_cast<uint32_t>(data.size()), 0);
+  return data == buffer.contents;
+}
+
+bool checkTexture(Driver* driver, Texture const& texture) {
+  for (size_t level = 0; level < texture.contents.size(); ++level) {
+    std::vector<uint8_t> const& contents = texture.contents[level];
+    ReadbackHandle const rh =
+        driver->readTextureAsync(texture.handle, uint8_t(level));
+    if (!rh) {
+      return false;
+    }
+    driver->flush();
+    while (!driver->isReadbackReady(rh)) {
+      std::this_thread::yield();
+    }
+    ReadbackView const view = driver->getReadbackView(rh);
+    bool const ok = view.byteCount == contents.size() &&
+                    memcmp(view.data, contents.data(), view.byteCount) == 0;
+    driver->releaseReadback(rh);
+    if (!ok) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  uint64_t const budget =
+      argc > 1 ? static_cast<uint64_t>(atoi(argv[1])) * 1024 * 1024
+               : 8ull * 1024 * 1024;
+  if (budget == 0) {
+    fprintf(stderr, "Budget must be positive\n");
+    return 1;
+  }
+
+  Platform* platform = PlatformFactory::create();
+  Driver* driver = platform->createDriver();
+  std::mt19937 random(1234);
+
+  std::vector<Buffer> buffers(BUFFER_COUNT);
+  std::vector<Texture> textures(TEXTURE_COUNT);
+  std::uniform_int_distribution<uint32_t> bufferSize(MIN_BUFFER_SIZE,
+                                                     MAX_BUFFER_SIZE);
+  std::uniform_int_distribution<uint32_t> textureSize(MIN_TEXTURE_SIZE,
+                                                      MAX_TEXTURE_SIZE);
+  // Interleave buffers and textures so that both share blocks.
+  for (uint32_t i = 0; i < BUFFER_COUNT; ++i) {
+    Buffer& buffer = buffers[i];
+    buffer.contents = makeContents(bufferSize(random) & ~3u, i);
+    uint32_t const size = static_cast<uint32_t>(buffer.contents.size());
+    buffer.handle = driver->createBufferObject(size, BufferUsage::STORAGE);
+    driver->updateBufferObject(buffer.handle, buffer.contents.data(), size,
+                               0);
+
+    if (i % (BUFFER_COUNT / TEXTURE_COUNT) == 0) {
+      uint32_t const index = i / (BUFFER_COUNT / TEXTURE_COUNT);
+      Texture& texture = textures[index];
+      texture.size = textureSize(random);
+      // Every other texture has a full mip chain so that relocation copies
+      // more than one level.
+      uint32_t levels = 1;
+      if (index % 2) {
+        while (texture.size >> levels) {
+          levels++;
+        }
+      }
+      texture.handle = driver->createTexture(
+          TextureFormat::RGBA8, texture.size, texture.size, uint8_t(levels),
+          TextureUsage::SAMPLEABLE | TextureUsage::UPLOADABLE |
+              TextureUsage::READABLE);
+      for (uint32_t level = 0; level < levels; ++level) {
+        uint32_t const size = std::max(texture.size >> level, 1u);
+        texture.contents.push_back(
+            makeContents(size_t(size) * size * 4, i + level));
+        driver->updateTexture(texture.handle, uint8_t(level),
+                              texture.contents[level].data(),
+                              texture.contents[level].size());
+      }
+    }
+    if (i % 64 == 63) {
+      driver->flush();
+    }
+  }
+
+  std::shuffle(buffers.begin(), buffers.end(), random);
+  std::shuffle(textures.begin(), textures.end(), random);
+  size_t const keptBuffers =
+      static_cast<size_t>(BUFFER_COUNT * (1.0f - DESTROY_RATIO));
+  size_t const keptTextures =
+      static_cast<size_t>(TEXTURE_COUNT * (1.0f - DESTROY_RATIO));
+  for (size_t i = keptBuffers; i < buffers.size(); ++i) {
+    driver->destroyBufferObject(buffers[i].handle);
+  }
+  for (size_t i = keptTextures; i < textures.size(); ++i) {
+    driver->destroyTexture(textures[i].handle);
+  }
+  buffers.resize(keptBuffers);
+  textures.resize(keptTextures);
+  driver->wait(driver->flush(), UINT64_MAX);
+  driver->flush();
+
+  MemoryFragmentation const before = driver->getMemoryFragmentation();
+
+  printf("%6s %10s %10s %10s\n", "frame", "moved", "resources", "blocks");
+  uint64_t totalMoved = 0;
+  uint32_t movingFrames = 0;
+  uint32_t idleWaits = 0;
+  bool finished = false;
+  while (movingFrames < MAX_FRAMES) {
+    DefragmentationStats const stats = driver->defragment(budget);
+    GpuFence const fence = driver->flush();
+    if (!stats.resourcesMoved && !stats.blocksEvacuating) {
+      finished = true;
+      break;
+    }
+    if (!stats.resourcesMoved) {
+      // Everything left in the evacuating blocks is already being copied.
+      // Wait for the copies so the blocks are released; this is not a frame.
+      if (++idleWaits > MAX_IDLE_WAITS) {
+        break;
+      }
+      driver->wait(fence, UINT64_MAX);
+      continue;
+    }
+    idleWaits = 0;
+    printf("%6u %8.2fMB %10u %10u\n", movingFrames, stats.bytesMoved / MB,
+           stats.resourcesMoved, stats.blocksEvacuating);
+    totalMoved += stats.bytesMoved;
+    movingFrames++;
+  }
+  // Let the copies finish so the emptied blocks are released.
+  driver->wait(driver->flush(), UINT64_MAX);
+  driver->flush();
+
+  MemoryFragmentation const after = driver->getMemoryFragmentation();
+  printFragmentation("before", before);
+  printFragmentation("after", after);
+  printf("Moved %.1fMB over %u frames, %.2fMB per frame with a %.1fMB "
+         "budget\n",
+         totalMoved / MB, movingFrames,
+         movingFrames ? totalMoved / MB / movingFrames : 0.0,
+         budget / MB);
+
+  // Moving nothing also keeps the block bytes from growing, so require the
+  // run to have actually compacted something.
+  bool ok = finished && totalMoved > 0 &&
+            after.blockBytes <= before.blockBytes &&
+            (after.blockCount < before.blockCount ||
+             after.fragmentation < before.fragmentation);
+  if (!ok) {
+    fprintf(stderr, "Defragmentation did not compact memory\n");
+  }
+  for (Buffer const& buffer : buffers) {
+    if (!checkBuffer(driver, buffer)) {
+      fprintf(stderr, "Buffer %u lost its contents\n",
+              buffer.handle.getId());
+      ok = false;
+    }
+    driver->destroyBufferObject(buffer.handle);
+  }
+  for (Texture const& texture : textures) {
+    if (!checkTexture(driver, texture)) {
+      fprintf(stderr, "Texture %u lost its contents\n",
+              texture.handle.getId());
+      ok = false;
+    }
+    driver->destroyTexture(texture.handle);
+  }
+
+  driver->terminate();
+  PlatformFactory::destroy(&platform);
+
+  printf("%s\n", ok ? "PASSED" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+// Shows the engine metrics surface and what it costs.
+//
+// First measures the cost of a counter increment with metrics disabled and
+// enabled, from one and from several threads. Then renders a few frames of
+// compute work with metrics enabled, printing the per-frame counters and
+// dumping the totals to a file in JSON or Prometheus text format.
+//
+// Usage: metrics_bench [dump path] [json|prometheus]
+
+#include <backend/Platform.h>
+#include <metrics/Metrics.h>
+#include <private/backend/Driver.h>
+#include <private/backend/PlatformFactory.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace engine::backend;
+using namespace engine::metrics;
+
+namespace {
+
+uint32_t const PATTERN_SPIRV[] = {
+#include "pattern.comp.inc"
+};
+
+constexpr uint32_t ITERATIONS = 10000000;
+constexpr uint32_t THREADS = 8;
+constexpr uint32_t FRAMES = 8;
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+
+using Clock = std::chrono::steady_clock;
+
+// Nanoseconds per Metrics::add() with |threads| threads adding at once.
+double measureAdd(uint32_t threads) {
+  auto const start = Clock::now();
+  std::vector<std::thread> workers;
+  for (uint32_t t = 0; t < threads; ++t) {
+    workers.emplace_back([]() {
+      for (uint32_t i = 0; i < ITERATIONS; ++i) {
+        Metrics::add(Counter::DRAWS);
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  double const seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  return seconds * 1e9 / ITERATIONS;
+}
+
+void printFrame(Snapshot const& frame) {
+  printf("%6llu", static_cast<unsigned long long>(frame.frame));
+  for (Counter counter :
+       {Counter::DISPATCHES, Counter::BARRIERS, Counter::PIPELINE_BINDS,
+        Counter::DESCRIPTOR_UPDATES, Counter::BYTES_UPLOADED,
+        Counter::ALLOCATIONS, Counter::SUBMITS}) {
+    printf(" %10llu", static_cast<unsigned long long>(frame.get(counter)));
+  }
+  HistogramData const& submit = frame.get(Histogram::QUEUE_SUBMIT_NS);
+  printf(" %9.1fus\n", submit.getMean() / 1000.0);
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  char const* dumpPath = argc > 1 ? argv[1] : nullptr;
+  DumpFormat const format = argc > 2 && strcmp(argv[2], "prometheus") == 0
+                                ? DumpFormat::PROMETHEUS
+                                : DumpFormat::JSON;
+
+  printf("Metrics::add() cost, ns per call and thread\n");
+  printf("%-10s %10s %10s\n", "", "1 thread", "8 threads");
+  Metrics::setEnabled(false);
+  printf("%-10s %10.2f %10.2f\n", "disabled", measureAdd(1),
+         measureAdd(THREADS));
+  Metrics::setEnabled(true);
+  printf("%-10s %10.2f %10.2f\n", "enabled", measureAdd(1),
+         measureAdd(THREADS));
+  // Keep the benchmark out of the frame counters below.
+  Metrics::endFrame();
+
+  Platform* platform = PlatformFactory::create();
+  Driver* driver = platform->createDriver();
+  if (dumpPath) {
+    Metrics::setDump(dumpPath, format, 1);
+  }
+
+  ComputeProgramDesc desc;
+  desc.spirv = PATTERN_SPIRV;
+  desc.spirvSize = sizeof(PATTERN_SPIRV);
+  desc.bindings = {DescriptorType::STORAGE_IMAGE};
+  desc.pushConstantSize = sizeof(uint32_t);
+  ProgramHandle const program = driver->createComputeProgram(desc);
+  TextureHandle const target =
+      driver->createTexture(TextureFormat::RGBA8, WIDTH, HEIGHT, 1,
+                            TextureUsage::STORAGE | TextureUsage::READABLE);
+  std::vector<uint8_t> constants(64 * 1024, 1);
+  BufferObjectHandle const buffer = driver->createBufferObject(
+      static_cast<uint32_t>(constants.size()), BufferUsage::UNIFORM);
+
+  printf("\n%6s %10s %10s %10s %10s %10s %10s %10s %11s\n", "frame",
+         "dispatches", "barriers", "binds", "desc", "uploaded", "allocs",
+         "submits", "submit");
+  for (uint32_t frame = 0; frame < FRAMES; ++frame) {
+    driver->updateBufferObject(buffer, constants.data(),
+                               static_cast<uint32_t>(constants.size()), 0);
+    ComputeDispatch dispatches[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+      ComputeDispatch& dispatch = dispatches[i];
+      dispatch.program = program;
+      ComputeBinding binding;
+      binding.texture = target;
+      dispatch.bindings.push_back(binding);
+      dispatch.groupCount[0] = (WIDTH + 7) / 8;
+      dispatch.groupCount[1] = (HEIGHT + 7) / 8;
+      dispatch.barrier = i > 0;
+      uint32_t const value = frame * 2 + i;
+      dispatch.setPushConstants(&value, sizeof(value));
+    }
+    driver->wait(driver->dispatchCompute(dispatches, 2), UINT64_MAX);
+    Metrics::endFrame();
+    printFrame(Metrics::getFrame());
+  }
+
+  driver->destroyBufferObject(buffer);
+  driver->destroyTexture(target);
+  driver->destroyProgram(program);
+  driver->terminate();
+  PlatformFactory::destroy(&platform);
+
+  Snapshot const totals = Metrics::getTotals();
+  HistogramData const& latency = totals.get(Histogram::SUBMIT_COMPLETE_NS);
+  printf("\nsubmit to completion: p50 %.1fus p99 %.1fus over %llu submits\n",
+         latency.getPercentile(0.5f) / 1000.0,
+         latency.getPercentile(0.99f) / 1000.0,
+         static_cast<unsigned long long>(latency.count));
+  if (dumpPath) {
+    printf("Totals written to %s\n", dumpPath);
+  }
+  return 0;
+}
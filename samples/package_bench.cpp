@@ -0,0 +1,238 @@
+// Measures time-to-resident for mesh and texture data loaded from an engine
+// package compared with a glTF-style import, where attributes are stored as
+// separate accessor streams that are read into heap buffers and interleaved
+// into the engine vertex layout afterwards.
+//
+// Usage: package_bench [directory] [iterations]
+
+#include <package/PackageReader.h>
+#include <package/PackageWriter.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace engine::package;
+
+namespace {
+
+constexpr uint32_t VERTEX_COUNT = 2 * 1024 * 1024;
+constexpr uint32_t INDEX_COUNT = 6 * 1024 * 1024;
+constexpr uint32_t TEXTURE_SIZE = 2048;
+constexpr uint32_t VERTEX_STRIDE = 32;
+
+struct SourceData {
+  std::vector<float> positions;
+  std::vector<float> normals;
+  std::vector<float> uvs;
+  std::vector<uint32_t> indices;
+  std::vector<uint8_t> texels;  // smallest mip first
+  TextureDesc texture;
+};
+
+// Staging memory the loaders copy into; touched up front so page faults do
+// not count against either loader.
+struct Destination {
+  std::vector<uint8_t> vertices;
+  std::vector<uint8_t> indices;
+  std::vector<uint8_t> texels;
+};
+
+SourceData makeSourceData() {
+  SourceData data;
+  data.positions.resize(VERTEX_COUNT * 3);
+  data.normals.resize(VERTEX_COUNT * 3);
+  data.uvs.resize(VERTEX_COUNT * 2);
+  for (uint32_t i = 0; i < VERTEX_COUNT; ++i) {
+    float const x = static_cast<float>(i % 1024);
+    float const y = static_cast<float>(i / 1024);
+    data.positions[i * 3 + 0] = x;
+    data.positions[i * 3 + 1] = y;
+    data.positions[i * 3 + 2] = 0.0f;
+    data.normals[i * 3 + 2] = 1.0f;
+    data.uvs[i * 2 + 0] = x / 1024.0f;
+    data.uvs[i * 2 + 1] = y / 2048.0f;
+  }
+  data.indices.resize(INDEX_COUNT);
+  for (uint32_t i = 0; i < INDEX_COUNT; ++i) {
+    data.indices[i] = (i / 3 + i % 3) % VERTEX_COUNT;
+  }
+
+  data.texture = {PixelFormat::RGBA8_UNORM, TEXTURE_SIZE, TEXTURE_SIZE, 12};
+  data.texels.resize(getMipOffset(data.texture, 0) +
+                     getMipSize(data.texture, 0));
+  for (size_t i = 0; i < data.texels.size(); ++i) {
+    data.texels[i] = static_cast<uint8_t>((i * 7) ^ (i >> 11));
+  }
+  return data;
+}
+
+void interleave(SourceData const& data, uint8_t* out) {
+  for (uint32_t i = 0; i < VERTEX_COUNT; ++i) {
+    float* v = reinterpret_cast<float*>(out + i * VERTEX_STRIDE);
+    memcpy(v, &data.positions[i * 3], 3 * sizeof(float));
+    memcpy(v + 3, &data.normals[i * 3], 3 * sizeof(float));
+    memcpy(v + 6, &data.uvs[i * 2], 2 * sizeof(float));
+  }
+}
+
+bool writePackage(SourceData const& data, std::string const& path,
+                  Compression compression) {
+  std::vector<uint8_t> vertices(VERTEX_COUNT * VERTEX_STRIDE);
+  interleave(data, vertices.data());
+
+  VertexBufferDesc vertexDesc{};
+  vertexDesc.vertexCount = VERTEX_COUNT;
+  vertexDesc.stride = VERTEX_STRIDE;
+  vertexDesc.attributeCount = 3;
+  vertexDesc.attributes[0] = {VertexSemantic::POSITION, VertexFormat::FLOAT3,
+                              0};
+  vertexDesc.attributes[1] = {VertexSemantic::NORMAL, VertexFormat::FLOAT3,
+                              12};
+  vertexDesc.attributes[2] = {VertexSemantic::UV0, VertexFormat::FLOAT2, 24};
+
+  PackageWriter writer;
+  writer.addVertexBuffer("mesh", vertexDesc, vertices.data(), vertices.size(),
+                         compression);
+  writer.addIndexBuffer("mesh", {INDEX_COUNT, IndexType::UINT32},
+                        data.indices.data(), data.indices.size() * 4,
+                        compression);
+  writer.addTexture("albedo", data.texture, data.texels.data(),
+                    data.texels.size(), compression);
+  return writer.write(path.c_str());
+}
+
+template <typename T>
+void writeStream(std::ofstream& out, std::vector<T> const& v) {
+  out.write(reinterpret_cast<char const*>(v.data()), v.size() * sizeof(T));
+}
+
+template <typename T>
+void readStream(std::ifstream& in, std::vector<T>& v, size_t count) {
+  v.resize(count);
+  in.read(reinterpret_cast<char*>(v.data()), count * sizeof(T));
+}
+
+bool writeAccessorFile(SourceData const& data, std::string const& path) {
+  std::ofstream out(path, std::ios::binary);
+  writeStream(out, data.positions);
+  writeStream(out, data.normals);
+  writeStream(out, data.uvs);
+  writeStream(out, data.indices);
+  writeStream(out, data.texels);
+  return out.good();
+}
+
+bool loadAccessors(std::string const& path, Destination& dst) {
+  std::ifstream in(path, std::ios::binary);
+  SourceData data;
+  readStream(in, data.positions, VERTEX_COUNT * 3);
+  readStream(in, data.normals, VERTEX_COUNT * 3);
+  readStream(in, data.uvs, VERTEX_COUNT * 2);
+  readStream(in, data.indices, INDEX_COUNT);
+  readStream(in, data.texels, dst.texels.size());
+  if (!in.good()) {
+    return false;
+  }
+  interleave(data, dst.vertices.data());
+  memcpy(dst.indices.data(), data.indices.data(), dst.indices.size());
+  memcpy(dst.texels.data(), data.texels.data(), dst.texels.size());
+  return true;
+}
+
+bool loadPackage(std::string const& path, Destination& dst) {
+  PackageReader reader;
+  if (!reader.open(path.c_str())) {
+    return false;
+  }
+  int32_t const vb = reader.findChunk(ChunkType::VERTEX_BUFFER, "mesh");
+  int32_t const ib = reader.findChunk(ChunkType::INDEX_BUFFER, "mesh");
+  int32_t const tex = reader.findChunk(ChunkType::TEXTURE, "albedo");
+  if (vb < 0 || ib < 0 || tex < 0) {
+    return false;
+  }
+  PackageReader::ReadRequest const requests[] = {
+      {static_cast<uint32_t>(vb), dst.vertices.data()},
+      {static_cast<uint32_t>(ib), dst.indices.data()},
+      {static_cast<uint32_t>(tex), dst.texels.data()},
+  };
+  return reader.readChunks(requests, 3);
+}
+
+template <typename F>
+double measure(uint32_t iterations, F&& load) {
+  std::vector<double> times;
+  for (uint32_t i = 0; i < iterations; ++i) {
+    auto const start = std::chrono::steady_clock::now();
+    if (!load()) {
+      return -1.0;
+    }
+    std::chrono::duration<double, std::milli> const elapsed =
+        std::chrono::steady_clock::now() - start;
+    times.push_back(elapsed.count());
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  std::string const dir = argc > 1 ? argv[1] : ".";
+  uint32_t const iterations =
+      argc > 2 ? static_cast<uint32_t>(std::max(atoi(argv[2]), 1)) : 5;
+
+  SourceData const data = makeSourceData();
+
+  Destination dst;
+  dst.vertices.assign(VERTEX_COUNT * VERTEX_STRIDE, 0);
+  dst.indices.assign(INDEX_COUNT * sizeof(uint32_t), 0);
+  dst.texels.assign(data.texels.size(), 0);
+
+  std::string const accessorPath = dir + "/bench_accessors.bin";
+  if (!writeAccessorFile(data, accessorPath)) {
+    fprintf(stderr, "Unable to write %s\n", accessorPath.c_str());
+    return 1;
+  }
+  double const baseline =
+      measure(iterations, [&]() { return loadAccessors(accessorPath, dst); });
+  printf("%-24s %8.2f ms\n", "glTF-style import", baseline);
+
+  struct Variant {
+    char const* name;
+    Compression compression;
+  };
+  Variant const variants[] = {
+      {"package (uncompressed)", Compression::NONE},
+      {"package (lz4)", Compression::LZ4},
+      {"package (zstd)", Compression::ZSTD},
+  };
+  for (auto const& variant : variants) {
+    if (!isCompressionSupported(variant.compression)) {
+      // The writer would silently store the chunks uncompressed.
+      printf("%-24s unavailable\n", variant.name);
+      continue;
+    }
+    std::string const path = dir + "/bench_" +
+                             std::to_string(static_cast<uint32_t>(
+                                 variant.compression)) +
+                             ".pkg";
+    if (!writePackage(data, path, variant.compression)) {
+      fprintf(stderr, "Unable to write %s\n", path.c_str());
+      return 1;
+    }
+    double const time =
+        measure(iterations, [&]() { return loadPackage(path, dst); });
+    if (time < 0.0) {
+      printf("%-24s unavailable\n", variant.name);
+      continue;
+    }
+    printf("%-24s %8.2f ms (%.2fx)\n", variant.name, time, baseline / time);
+  }
+  return 0;
+}
@@ -0,0 +1,212 @@
+// Measures sustained headless frame capture throughput. Every frame a
+// compute pass renders into an RGBA8 image that is then read back to the
+// CPU and consumed, the way a capture pipeline hands frames to an encoder.
+//
+// Two strategies are compared:
+//   sync   - wait for each frame's readback before rendering the next one,
+//   async  - keep readbacks in flight in the ring and consume whichever
+//            frames are ready while the GPU keeps rendering.
+//
+// Usage: readback_bench [frames]
+
+#include <backend/Platform.h>
+#include <private/backend/Driver.h>
+#include <private/backend/PlatformFactory.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <deque>
+#include <thread>
+
+using namespace engine::backend;
+
+namespace {
+
+uint32_t const PATTERN_SPIRV[] = {
+#include "pattern.comp.inc"
+};
+
+struct Resolution {
+  char const* name;
+  uint32_t width;
+  uint32_t height;
+};
+
+constexpr Resolution RESOLUTIONS[] = {
+    {"1080p", 1920, 1080},
+    {"4K", 3840, 2160},
+};
+
+using Clock = std::chrono::steady_clock;
+
+class CaptureBench {
+ public:
+  CaptureBench(Driver* driver, ProgramHandle program, Resolution resolution)
+      : mDriver(driver), mResolution(resolution) {
+    mTarget = driver->createTexture(
+        TextureFormat::RGBA8, resolution.width, resolution.height, 1,
+        TextureUsage::STORAGE | TextureUsage::READABLE);
+    mDispatch.program = program;
+    ComputeBinding binding;
+    binding.texture = mTarget;
+    mDispatch.bindings.push_back(binding);
+    mDispatch.groupCount[0] = (resolution.width + 7) / 8;
+    mDispatch.groupCount[1] = (resolution.height + 7) / 8;
+  }
+
+  ~CaptureBench() { mDriver->destroyTexture(mTarget); }
+
+  double runSync(uint32_t frames) {
+    auto const start = Clock::now();
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      render(frame);
+      ReadbackHandle const rh = mDriver->readTextureAsync(mTarget, 0);
+      if (!rh) {
+        return fail();
+      }
+      mDriver->wait(mDriver->flush(), UINT64_MAX);
+      consume(rh, frame);
+    }
+    return fps(frames, start);
+  }
+
+  double runAsync(uint32_t frames) {
+    auto const start = Clock::now();
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      render(frame);
+      ReadbackHandle rh = mDriver->readTextureAsync(mTarget, 0);
+      while (!rh) {
+        if (mPending.empty()) {
+          return fail();
+        }
+        // The ring is full; the oldest frame has to be consumed first.
+        consumeOldest();
+        rh = mDriver->readTextureAsync(mTarget, 0);
+      }
+      mPending.push_back({rh, frame});
+      while (!mPending.empty() &&
+             mDriver->isReadbackReady(mPending.front().handle)) {
+        consumeOldest();
+      }
+    }
+    // The last frame's readback has no later dispatch to submit it.
+    mDriver->flush();
+    while (!mPending.empty()) {
+      consumeOldest();
+    }
+    return fps(frames, start);
+  }
+
+  bool isValid() const noexcept { return mValid; }
+
+ private:
+  struct Pending {
+    ReadbackHandle handle;
+    uint32_t frame;
+  };
+
+  void render(uint32_t frame) {
+    mDispatch.setPushConstants(&frame, sizeof(frame));
+    mDriver->dispatchCompute(&mDispatch, 1);
+  }
+
+  // The readback ring cannot hold a single frame.
+  double fail() {
+    fprintf(stderr, "%s: frame does not fit in the readback ring\n",
+            mResolution.name);
+    mValid = false;
+    return 0.0;
+  }
+
+  void consumeOldest() {
+    Pending const pending = mPending.front();
+    mPending.pop_front();
+    while (!mDriver->isReadbackReady(pending.handle)) {
+      std::this_thread::yield();
+    }
+    consume(pending.handle, pending.frame);
+  }
+
+  // Stands in for the encoder: touches every byte of the frame and checks
+  // a few texels against the pattern.
+  void consume(ReadbackHandle rh, uint32_t frame) {
+    ReadbackView const view = mDriver->getReadbackView(rh);
+    uint8_t const* texels = static_cast<uint8_t const*>(view.data);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < view.byteCount; i += sizeof(uint64_t)) {
+      sum += *reinterpret_cast<uint64_t const*>(texels + i);
+    }
+    mChecksum += sum;
+
+    uint32_t const x = (frame * 7) % mResolution.width;
+    uint32_t const y = (frame * 13) % mResolution.height;
+    uint8_t const* texel = texels + y * view.rowPitch + x * 4;
+    if (texel[0] != uint8_t(x + frame) || texel[1] != uint8_t(y) ||
+        texel[2] != uint8_t(frame) || texel[3] != 255) {
+      fprintf(stderr, "%s frame %u: texel (%u, %u) does not match\n",
+              mResolution.name, frame, x, y);
+      mValid = false;
+    }
+    mDriver->releaseReadback(rh);
+  }
+
+  static double fps(uint32_t frames, Clock::time_point start) {
+    double const seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    return frames / seconds;
+  }
+
+  Driver* const mDriver;
+  Resolution const mResolution;
+  TextureHandle mTarget;
+  ComputeDispatch mDispatch;
+  std::deque<Pending> mPending;
+  uint64_t mChecksum = 0;
+  bool mValid = true;
+};
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  uint32_t const frames =
+      argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 120;
+  if (frames == 0) {
+    fprintf(stderr, "Frame count must be positive\n");
+    return 1;
+  }
+
+  Platform* platform = PlatformFactory::create();
+  Driver* driver = platform->createDriver();
+
+  ComputeProgramDesc desc;
+  desc.spirv = PATTERN_SPIRV;
+  desc.spirvSize = sizeof(PATTERN_SPIRV);
+  desc.bindings = {DescriptorType::STORAGE_IMAGE};
+  desc.pushConstantSize = sizeof(uint32_t);
+  ProgramHandle const program = driver->createComputeProgram(desc);
+
+  bool ok = true;
+  printf("%-8s %10s %10s %8s\n", "", "sync fps", "async fps", "speedup");
+  for (Resolution const& resolution : RESOLUTIONS) {
+    CaptureBench bench(driver, program, resolution);
+    // Warm up the pipeline, the readback ring and the page mappings.
+    bench.runAsync(4);
+    if (!bench.isValid()) {
+      ok = false;
+      continue;
+    }
+    double const sync = bench.runSync(frames);
+    double const async = bench.runAsync(frames);
+    printf("%-8s %10.1f %10.1f %7.2fx\n", resolution.name, sync, async,
+           async / sync);
+    ok &= bench.isValid();
+  }
+
+  driver->destroyProgram(program);
+  driver->terminate();
+  PlatformFactory::destroy(&platform);
+
+  printf("%s\n", ok ? "PASSED" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+// Headless texture streaming scene. A corridor is lined with textured panels
+// and a scripted camera walks down it and back while looking ahead. Every
+// frame the projected size of each visible panel is reported to the
+// streamer, which has to keep the panels near the camera sharp within a
+// budget far smaller than the full mip chains.
+//
+// Prints residency and upload bandwidth as the camera moves and fails if
+// the resident and retiring textures ever exceed the budget or if demand
+// that fits in the budget is not met once the camera stops.
+//
+// Usage: streaming_scene [directory]
+
+#include <backend/Platform.h>
+#include <math.h>
+#include <package/PackageReader.h>
+#include <package/PackageWriter.h>
+#include <private/backend/Driver.h>
+#include <private/backend/PlatformFactory.h>
+#include <stdio.h>
+#include <streaming/TextureStreamer.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace engine::backend;
+using namespace engine::package;
+using namespace engine::streaming;
+
+namespace {
+
+constexpr uint32_t PANEL_COUNT = 48;
+constexpr uint32_t TEXTURE_SIZE = 1024;
+constexpr uint32_t TEXTURE_LEVELS = 11;
+constexpr float PANEL_SPACING = 4.0f;  // meters along the corridor
+constexpr float PANEL_SIZE = 2.0f;
+constexpr float CORRIDOR_HALF_WIDTH = 2.0f;
+constexpr float CAMERA_SPEED = 0.25f;  // meters per frame
+constexpr uint32_t SETTLE_FRAMES = 120;
+
+constexpr uint32_t VIEW_WIDTH = 1920;
+constexpr uint32_t VIEW_HEIGHT = 1080;
+constexpr float FOV_Y = 60.0f * 3.14159265f / 180.0f;
+
+constexpr uint64_t BUDGET = 64ull * 1024 * 1024;
+constexpr uint64_t TRANSFER_PER_FRAME = 4ull * 1024 * 1024;
+
+constexpr double MB = 1024.0 * 1024.0;
+
+bool writeScenePackage(std::string const& path) {
+  TextureDesc const desc = {PixelFormat::RGBA8_UNORM, TEXTURE_SIZE,
+                            TEXTURE_SIZE, TEXTURE_LEVELS};
+  std::vector<uint8_t> texels(getMipOffset(desc, 0) + getMipSize(desc, 0));
+  PackageWriter writer;
+  for (uint32_t panel = 0; panel < PANEL_COUNT; ++panel) {
+    for (size_t i = 0; i < texels.size(); ++i) {
+      texels[i] = static_cast<uint8_t>(i * 13 + panel * 31);
+    }
+    std::string const name = "panel" + std::to_string(panel);
+    writer.addTexture(name.c_str(), desc, texels.data(), texels.size());
+  }
+  return writer.write(path.c_str());
+}
+
+// Panels alternate between the left and right walls, facing the center.
+struct Panel {
+  float x;
+  float z;
+  StreamedTextureId texture;
+};
+
+// Pixels covered by the panel's edge, or 0 when it is off screen.
+float projectPanel(Panel const& panel, float cameraZ, float direction) {
+  float const depth = (cameraZ - panel.z) * direction;
+  if (depth <= 0.1f) {
+    return 0.0f;
+  }
+  float const focal = 0.5f * VIEW_HEIGHT / tanf(0.5f * FOV_Y);
+  float const aspect = float(VIEW_WIDTH) / float(VIEW_HEIGHT);
+  // Cull against the horizontal extent of the frustum, allowing for the
+  // panel's own width.
+  if (fabsf(panel.x) - 0.5f * PANEL_SIZE >
+      depth * aspect * tanf(0.5f * FOV_Y)) {
+    return 0.0f;
+  }
+  // Panels are seen at a grazing angle; the vertical edge is a fair measure
+  // of the footprint.
+  return PANEL_SIZE * focal / depth;
+}
+
+struct SceneResult {
+  bool withinBudget = true;
+  uint64_t peakAllocated = 0;
+  uint32_t frames = 0;
+};
+
+void printHeader() {
+  printf("%6s %8s %10s %10s %10s %10s %10s %10s %8s\n", "frame", "camera",
+         "resident", "budget", "demanded", "upload", "copied", "evicted",
+         "target");
+}
+
+void printStats(uint32_t frame, float cameraZ, StreamingStats const& stats) {
+  printf(
+      "%6u %7.1fm %8.1fMB %8.1fMB %8.1fMB %8.2fMB %8.2fMB %8.2fMB %4u/%-3u\n",
+      frame, -cameraZ, stats.residentBytes / MB, stats.budgetBytes / MB,
+      stats.demandedBytes / MB, stats.uploadedBytes / MB,
+      stats.copiedBytes / MB, stats.evictedBytes / MB,
+      stats.texturesAtTarget, stats.textureCount);
+}
+
+// Walks to the end of the corridor, turns around and walks back, then
+// stands still so streaming can catch up.
+SceneResult runScene(TextureStreamer& streamer,
+                     std::vector<Panel> const& panels) {
+  float const length = PANEL_SPACING * PANEL_COUNT;
+  uint32_t const walkFrames = static_cast<uint32_t>(length / CAMERA_SPEED);
+  uint32_t const totalFrames = 2 * walkFrames + SETTLE_FRAMES;
+
+  SceneResult result;
+  printHeader();
+  for (uint32_t frame = 0; frame < totalFrames; ++frame) {
+    float cameraZ;
+    float direction;
+    if (frame < walkFrames) {
+      cameraZ = PANEL_SPACING - frame * CAMERA_SPEED;
+      direction = 1.0f;
+    } else {
+      uint32_t const back = std::min(frame - walkFrames, walkFrames);
+      cameraZ = PANEL_SPACING - length + back * CAMERA_SPEED;
+      direction = -1.0f;
+    }
+
+    for (Panel const& panel : panels) {
+      float const screenSize = projectPanel(panel, cameraZ, direction);
+      if (screenSize > 0.0f) {
+        streamer.reportUsage(panel.texture, screenSize);
+      }
+    }
+    streamer.update();
+
+    StreamingStats const& stats = streamer.getStats();
+    // Replaced textures are still allocated until the GPU is done with
+    // them, so they are part of what the budget has to cover.
+    uint64_t const allocated = stats.residentBytes + stats.retiringBytes;
+    result.peakAllocated = std::max(result.peakAllocated, allocated);
+    if (allocated > stats.budgetBytes) {
+      fprintf(stderr, "frame %u: %.1fMB allocated over a %.1fMB budget\n",
+              frame, allocated / MB, stats.budgetBytes / MB);
+      result.withinBudget = false;
+    }
+    if (frame % 60 == 0 || frame + 1 == totalFrames) {
+      printStats(frame, cameraZ, stats);
+    }
+  }
+  result.frames = totalFrames;
+  return result;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  std::string const dir = argc > 1 ? argv[1] : ".";
+  std::string const path = dir + "/streaming_scene.pkg";
+  if (!writeScenePackage(path)) {
+    fprintf(stderr, "Unable to write %s\n", path.c_str());
+    return 1;
+  }
+  PackageReader reader;
+  if (!reader.open(path.c_str())) {
+    fprintf(stderr, "Unable to open %s\n", path.c_str());
+    return 1;
+  }
+
+  Platform* platform = PlatformFactory::create();
+  Driver* driver = platform->createDriver();
+
+  MemoryBudget const device = driver->getMemoryBudget();
+  if (device.budget) {
+    printf("Device budget %.1fMB, usage %.1fMB; capped at %.1fMB\n",
+           device.budget / MB, device.usage / MB, BUDGET / MB);
+  } else {
+    printf("No device budget reported; capped at %.1fMB\n", BUDGET / MB);
+  }
+
+  bool ok = true;
+  {
+    StreamingConfig config;
+    config.budgetBytes = BUDGET;
+    config.transferBytesPerFrame = TRANSFER_PER_FRAME;
+    TextureStreamer streamer(driver, config);
+
+    std::vector<Panel> panels;
+    for (uint32_t i = 0; i < PANEL_COUNT; ++i) {
+      Panel panel;
+      panel.x = (i % 2 ? 1.0f : -1.0f) * CORRIDOR_HALF_WIDTH;
+      panel.z = -PANEL_SPACING * i;
+      panel.texture = streamer.addTexture(reader, i);
+      if (panel.texture == INVALID_STREAMED_TEXTURE) {
+        ok = false;
+        break;
+      }
+      panels.push_back(panel);
+    }
+
+    if (ok) {
+      SceneResult const result = runScene(streamer, panels);
+      StreamingStats const& stats = streamer.getStats();
+      TextureDesc const& desc = reader.getChunk(0).texture;
+      double const fullChains =
+          double(getMipOffset(desc, 0) + getMipSize(desc, 0)) * PANEL_COUNT;
+      printf("Full chains %.1fMB, peak allocated %.1fMB\n", fullChains / MB,
+             result.peakAllocated / MB);
+      printf("Uploaded %.1fMB (%.2fMB/frame), copied %.1fMB (%.2fMB/frame), "
+             "evicted %.1fMB\n",
+             stats.totalUploadedBytes / MB,
+             stats.totalUploadedBytes / MB / result.frames,
+             stats.totalCopiedBytes / MB,
+             stats.totalCopiedBytes / MB / result.frames,
+             stats.totalEvictedBytes / MB);
+      ok &= result.withinBudget;
+      if (stats.demandedBytes <= stats.budgetBytes &&
+          stats.texturesAtTarget != stats.textureCount) {
+        fprintf(stderr, "Only %u of %u textures at target after settling\n",
+                stats.texturesAtTarget, stats.textureCount);
+        ok = false;
+      }
+    }
+  }
+
+  driver->terminate();
+  PlatformFactory::destroy(&platform);
+  remove(path.c_str());
+
+  printf("%s\n", ok ? "PASSED" : "FAILED");
+  return ok ? 0 : 1;
+}
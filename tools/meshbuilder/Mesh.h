@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace engine::meshbuilder {
+
+struct Vertex {
+  float position[3];
+  float normal[3];
+  float uv[2];
+};
+
+struct Mesh {
+  std::string name;
+  std::vector<Vertex> vertices;
+  // LOD 0 first; every LOD indexes the same vertex buffer.
+  std::vector<std::vector<uint32_t>> lods;
+};
+
+}  // namespace engine::meshbuilder
@@ -0,0 +1,332 @@
+#include "MeshOptimizer.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace engine::meshbuilder {
+
+namespace {
+
+constexpr int32_t kCacheSize = 32;
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriangleScore = 0.75f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+
+float vertexScore(int32_t cachePosition, uint32_t liveTriangles) {
+  if (liveTriangles == 0) {
+    return -1.0f;
+  }
+  float score = 0.0f;
+  if (cachePosition >= 0) {
+    if (cachePosition < 3) {
+      score = kLastTriangleScore;
+    } else {
+      float const scaler = 1.0f / (kCacheSize - 3);
+      score = powf(1.0f - (cachePosition - 3) * scaler, kCacheDecayPower);
+    }
+  }
+  return score + kValenceBoostScale *
+                     powf(static_cast<float>(liveTriangles),
+                          -kValenceBoostPower);
+}
+
+// A triangle with the smallest index rotated first; winding is preserved.
+struct TriangleKey {
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+
+  bool operator==(TriangleKey const& rhs) const noexcept {
+    return a == rhs.a && b == rhs.b && c == rhs.c;
+  }
+};
+
+struct TriangleKeyHash {
+  size_t operator()(TriangleKey const& key) const noexcept {
+    uint64_t h = key.a;
+    h = h * 0x9e3779b97f4a7c15ull ^ key.b;
+    h = h * 0x9e3779b97f4a7c15ull ^ key.c;
+    return static_cast<size_t>(h ^ (h >> 32));
+  }
+};
+
+TriangleKey triangleKey(uint32_t a, uint32_t b, uint32_t c) {
+  if (b < a && b < c) {
+    std::swap(a, b);
+    std::swap(b, c);
+  } else if (c < a && c < b) {
+    std::swap(a, c);
+    std::swap(b, c);
+  }
+  return {a, b, c};
+}
+
+// Collapses every vertex to a representative per grid cell and returns the
+// surviving, de-duplicated triangles.
+std::vector<uint32_t> clusterVertices(Mesh const& mesh,
+                                      std::vector<uint32_t> const& indices,
+                                      uint32_t resolution) {
+  float lo[3] = {INFINITY, INFINITY, INFINITY};
+  float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+  for (uint32_t index : indices) {
+    for (int a = 0; a < 3; ++a) {
+      lo[a] = std::min(lo[a], mesh.vertices[index].position[a]);
+      hi[a] = std::max(hi[a], mesh.vertices[index].position[a]);
+    }
+  }
+  float const extent =
+      std::max({hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2], 1e-6f});
+  float const cellScale = resolution / extent;
+
+  auto cellOf = [&](uint32_t vertex) {
+    uint64_t key = 0;
+    for (int a = 0; a < 3; ++a) {
+      float const t = (mesh.vertices[vertex].position[a] - lo[a]) * cellScale;
+      uint64_t const cell =
+          std::min(static_cast<uint64_t>(t), uint64_t{resolution - 1});
+      key = (key << 21) | cell;
+    }
+    return key;
+  };
+
+  struct Cell {
+    float sum[3] = {};
+    uint32_t count = 0;
+    uint32_t representative = ~0u;
+    float bestDistance = INFINITY;
+  };
+  std::unordered_map<uint64_t, Cell> cells;
+  std::unordered_map<uint32_t, uint64_t> vertexCells;
+  for (uint32_t index : indices) {
+    if (vertexCells.count(index)) {
+      continue;
+    }
+    uint64_t const key = cellOf(index);
+    vertexCells[index] = key;
+    Cell& cell = cells[key];
+    for (int a = 0; a < 3; ++a) {
+      cell.sum[a] += mesh.vertices[index].position[a];
+    }
+    cell.count++;
+  }
+  // The representative is the vertex closest to the cell centroid.
+  for (auto const& [vertex, key] : vertexCells) {
+    Cell& cell = cells[key];
+    float distance = 0.0f;
+    for (int a = 0; a < 3; ++a) {
+      float const d =
+          mesh.vertices[vertex].position[a] - cell.sum[a] / cell.count;
+      distance += d * d;
+    }
+    if (distance < cell.bestDistance ||
+        (distance == cell.bestDistance && vertex < cell.representative)) {
+      cell.bestDistance = distance;
+      cell.representative = vertex;
+    }
+  }
+
+  std::vector<uint32_t> result;
+  std::unordered_set<TriangleKey, TriangleKeyHash> seen;
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    uint32_t const a = cells[vertexCells[indices[i + 0]]].representative;
+    uint32_t const b = cells[vertexCells[indices[i + 1]]].representative;
+    uint32_t const c = cells[vertexCells[indices[i + 2]]].representative;
+    if (a == b || b == c || a == c) {
+      continue;
+    }
+    if (!seen.insert(triangleKey(a, b, c)).second) {
+      continue;
+    }
+    result.push_back(a);
+    result.push_back(b);
+    result.push_back(c);
+  }
+  return result;
+}
+
+}  // anonymous namespace
+
+VertexCacheStats analyzeVertexCache(std::vector<uint32_t> const& indices,
+                                    size_t vertexCount, uint32_t cacheSize) {
+  std::vector<uint32_t> cache(cacheSize, ~0u);
+  std::vector<bool> referenced(vertexCount, false);
+  size_t head = 0;
+  size_t misses = 0;
+  size_t uniqueVertices = 0;
+  for (uint32_t index : indices) {
+    if (!referenced[index]) {
+      referenced[index] = true;
+      uniqueVertices++;
+    }
+    if (std::find(cache.begin(), cache.end(), index) != cache.end()) {
+      continue;
+    }
+    cache[head] = index;
+    head = (head + 1) % cacheSize;
+    misses++;
+  }
+  size_t const triangles = indices.size() / 3;
+  return {triangles ? static_cast<float>(misses) / triangles : 0.0f,
+          uniqueVertices ? static_cast<float>(misses) / uniqueVertices : 0.0f};
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+  size_t const triangleCount = indices.size() / 3;
+  if (triangleCount == 0) {
+    return;
+  }
+
+  // Per-vertex lists of triangles that have not been emitted yet.
+  std::vector<uint32_t> liveTriangles(vertexCount, 0);
+  for (uint32_t index : indices) {
+    liveTriangles[index]++;
+  }
+  std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+  }
+  std::vector<uint32_t> adjacency(indices.size());
+  {
+    std::vector<uint32_t> fill(adjacencyOffset.begin(),
+                               adjacencyOffset.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+      adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+  }
+
+  std::vector<int32_t> cachePosition(vertexCount, -1);
+  std::vector<float> score(vertexCount);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    score[v] = vertexScore(-1, liveTriangles[v]);
+  }
+
+  std::vector<bool> emitted(triangleCount, false);
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+  std::vector<uint32_t> cache;
+  std::vector<uint32_t> nextCache;
+  cache.reserve(kCacheSize + 3);
+  nextCache.reserve(kCacheSize + 3);
+
+  size_t cursor = 0;
+  int64_t best = -1;
+  for (size_t emittedCount = 0; emittedCount < triangleCount;
+       ++emittedCount) {
+    if (best < 0) {
+      // Dead end: continue with the next triangle in input order.
+      while (emitted[cursor]) {
+        cursor++;
+      }
+      best = static_cast<int64_t>(cursor);
+    }
+
+    uint32_t const* tri = &indices[best * 3];
+    output.insert(output.end(), tri, tri + 3);
+    emitted[best] = true;
+
+    for (int k = 0; k < 3; ++k) {
+      uint32_t const v = tri[k];
+      uint32_t* begin = &adjacency[adjacencyOffset[v]];
+      uint32_t* end = begin + liveTriangles[v];
+      uint32_t* it = std::find(begin, end, static_cast<uint32_t>(best));
+      std::swap(*it, *(end - 1));
+      liveTriangles[v]--;
+    }
+
+    nextCache.assign(tri, tri + 3);
+    for (uint32_t v : cache) {
+      if (v != tri[0] && v != tri[1] && v != tri[2]) {
+        nextCache.push_back(v);
+      }
+    }
+    for (size_t i = 0; i < nextCache.size(); ++i) {
+      uint32_t const v = nextCache[i];
+      cachePosition[v] =
+          i < static_cast<size_t>(kCacheSize) ? static_cast<int32_t>(i) : -1;
+      score[v] = vertexScore(cachePosition[v], liveTriangles[v]);
+    }
+
+    // Rescore the live triangles touching the cache and pick the best one.
+    best = -1;
+    float bestScore = -1.0f;
+    for (uint32_t v : nextCache) {
+      uint32_t const* adj = &adjacency[adjacencyOffset[v]];
+      for (uint32_t i = 0; i < liveTriangles[v]; ++i) {
+        uint32_t const t = adj[i];
+        float const s = score[indices[t * 3 + 0]] +
+                        score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+        if (s > bestScore) {
+          bestScore = s;
+          best = t;
+        }
+      }
+    }
+
+    if (nextCache.size() > static_cast<size_t>(kCacheSize)) {
+      nextCache.resize(kCacheSize);
+    }
+    std::swap(cache, nextCache);
+  }
+
+  indices = std::move(output);
+}
+
+void optimizeVertexFetch(Mesh& mesh) {
+  std::vector<uint32_t> remap(mesh.vertices.size(), ~0u);
+  std::vector<Vertex> vertices;
+  vertices.reserve(mesh.vertices.size());
+  for (auto const& lod : mesh.lods) {
+    for (uint32_t index : lod) {
+      if (remap[index] == ~0u) {
+        remap[index] = static_cast<uint32_t>(vertices.size());
+        vertices.push_back(mesh.vertices[index]);
+      }
+    }
+  }
+  for (auto& lod : mesh.lods) {
+    for (uint32_t& index : lod) {
+      index = remap[index];
+    }
+  }
+  mesh.vertices = std::move(vertices);
+}
+
+void generateLods(Mesh& mesh, uint32_t count) {
+  constexpr uint32_t kMaxResolution = 1u << 20;
+  for (uint32_t lod = 0; lod < count; ++lod) {
+    std::vector<uint32_t> const& source = mesh.lods.back();
+    size_t const sourceTriangles = source.size() / 3;
+    size_t const target = sourceTriangles / 2;
+    if (target < 8) {
+      break;
+    }
+
+    // Largest grid resolution whose output fits the target.
+    std::vector<uint32_t> best;
+    uint32_t lo = 1;
+    uint32_t hi = kMaxResolution;
+    while (lo <= hi) {
+      uint32_t const mid = lo + (hi - lo) / 2;
+      std::vector<uint32_t> candidate = clusterVertices(mesh, source, mid);
+      if (candidate.size() / 3 <= target) {
+        best = std::move(candidate);
+        lo = mid + 1;
+      } else {
+        hi = mid - 1;
+      }
+    }
+
+    size_t const triangles = best.size() / 3;
+    if (triangles == 0 || triangles * 10 > sourceTriangles * 9) {
+      break;
+    }
+    optimizeVertexCache(best, mesh.vertices.size());
+    mesh.lods.push_back(std::move(best));
+  }
+}
+
+}  // namespace engine::meshbuilder
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "Mesh.h"
+
+namespace engine::meshbuilder {
+
+struct VertexCacheStats {
+  float acmr;  // cache misses per triangle
+  float atvr;  // cache misses per referenced vertex, 1.0 is optimal
+};
+
+// Simulates a FIFO post-transform cache of |cacheSize| entries.
+VertexCacheStats analyzeVertexCache(std::vector<uint32_t> const& indices,
+                                    size_t vertexCount,
+                                    uint32_t cacheSize = 16);
+
+// Reorders triangles for post-transform cache reuse (Forsyth's linear-speed
+// vertex cache optimization).
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+// Reorders vertices in the order the LODs first reference them, walking LOD 0
+// first, and drops vertices that no LOD references; all LODs are remapped.
+void optimizeVertexFetch(Mesh& mesh);
+
+// Appends up to |count| LODs, each targeting half the triangles of the one
+// before, built by vertex clustering on a uniform grid. Stops early when a
+// level no longer reduces the triangle count meaningfully.
+void generateLods(Mesh& mesh, uint32_t count);
+
+}  // namespace engine::meshbuilder
@@ -0,0 +1,150 @@
+#include "Meshlets.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace engine::meshbuilder {
+
+using namespace engine::package;
+
+namespace {
+
+void normalize(float v[3]) {
+  float const length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  if (length > 0.0f) {
+    v[0] /= length;
+    v[1] /= length;
+    v[2] /= length;
+  }
+}
+
+void computeBounds(Mesh const& mesh, Meshlets const& result,
+                   MeshletDesc& meshlet) {
+  uint32_t const* vertices = &result.vertices[meshlet.vertexOffset];
+  uint8_t const* triangles = &result.triangles[meshlet.triangleOffset];
+
+  float lo[3] = {INFINITY, INFINITY, INFINITY};
+  float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+  for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+    float const* p = mesh.vertices[vertices[i]].position;
+    for (int a = 0; a < 3; ++a) {
+      lo[a] = std::min(lo[a], p[a]);
+      hi[a] = std::max(hi[a], p[a]);
+    }
+  }
+  float radius = 0.0f;
+  for (int a = 0; a < 3; ++a) {
+    meshlet.center[a] = (lo[a] + hi[a]) * 0.5f;
+  }
+  for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+    float const* p = mesh.vertices[vertices[i]].position;
+    float const dx = p[0] - meshlet.center[0];
+    float const dy = p[1] - meshlet.center[1];
+    float const dz = p[2] - meshlet.center[2];
+    radius = std::max(radius, dx * dx + dy * dy + dz * dz);
+  }
+  meshlet.radius = sqrtf(radius);
+
+  std::vector<float> normals;
+  normals.reserve(meshlet.triangleCount * 3);
+  float axis[3] = {};
+  for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+    float const* a = mesh.vertices[vertices[triangles[t * 3 + 0]]].position;
+    float const* b = mesh.vertices[vertices[triangles[t * 3 + 1]]].position;
+    float const* c = mesh.vertices[vertices[triangles[t * 3 + 2]]].position;
+    float const e0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    float const e1[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    float n[3] = {e0[1] * e1[2] - e0[2] * e1[1],
+                  e0[2] * e1[0] - e0[0] * e1[2],
+                  e0[0] * e1[1] - e0[1] * e1[0]};
+    normalize(n);
+    normals.insert(normals.end(), n, n + 3);
+    axis[0] += n[0];
+    axis[1] += n[1];
+    axis[2] += n[2];
+  }
+  normalize(axis);
+
+  float minDot = 1.0f;
+  for (size_t i = 0; i < normals.size(); i += 3) {
+    minDot = std::min(minDot, axis[0] * normals[i] + axis[1] * normals[i + 1] +
+                                  axis[2] * normals[i + 2]);
+  }
+  memcpy(meshlet.coneAxis, axis, sizeof(axis));
+  // Cones wider than ~84 degrees are never culled.
+  meshlet.coneCutoff = minDot <= 0.1f ? 1.0f : sqrtf(1.0f - minDot * minDot);
+}
+
+}  // anonymous namespace
+
+Meshlets buildMeshlets(Mesh const& mesh, std::vector<uint32_t> const& indices,
+                       uint32_t maxVertices, uint32_t maxTriangles) {
+  Meshlets result;
+  std::unordered_map<uint32_t, uint8_t> local;
+  MeshletDesc current{};
+
+  auto finish = [&]() {
+    if (current.triangleCount == 0) {
+      return;
+    }
+    computeBounds(mesh, result, current);
+    result.meshlets.push_back(current);
+    // Keep every meshlet's triangle list 4-byte aligned.
+    result.triangles.resize((result.triangles.size() + 3) & ~size_t{3}, 0);
+    current = {};
+    current.vertexOffset = static_cast<uint32_t>(result.vertices.size());
+    current.triangleOffset = static_cast<uint32_t>(result.triangles.size());
+    local.clear();
+  };
+
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    uint32_t newVertices = 0;
+    for (int k = 0; k < 3; ++k) {
+      newVertices += local.count(indices[i + k]) ? 0 : 1;
+    }
+    if (current.vertexCount + newVertices > maxVertices ||
+        current.triangleCount + 1 > maxTriangles) {
+      finish();
+    }
+    for (int k = 0; k < 3; ++k) {
+      uint32_t const vertex = indices[i + k];
+      auto [it, inserted] =
+          local.emplace(vertex, static_cast<uint8_t>(current.vertexCount));
+      if (inserted) {
+        result.vertices.push_back(vertex);
+        current.vertexCount++;
+      }
+      result.triangles.push_back(it->second);
+    }
+    current.triangleCount++;
+  }
+  finish();
+  return result;
+}
+
+std::vector<uint8_t> packMeshlets(Meshlets const& meshlets,
+                                  MeshletsDesc& desc, uint32_t maxVertices,
+                                  uint32_t maxTriangles) {
+  size_t const headerSize = meshlets.meshlets.size() * sizeof(MeshletDesc);
+  size_t const vertexSize = meshlets.vertices.size() * sizeof(uint32_t);
+
+  desc = {};
+  desc.meshletCount = static_cast<uint32_t>(meshlets.meshlets.size());
+  desc.maxVertices = maxVertices;
+  desc.maxTriangles = maxTriangles;
+  desc.vertexIndexOffset = static_cast<uint32_t>(headerSize);
+  desc.triangleIndexOffset = static_cast<uint32_t>(headerSize + vertexSize);
+
+  std::vector<uint8_t> out(headerSize + vertexSize +
+                           meshlets.triangles.size());
+  memcpy(out.data(), meshlets.meshlets.data(), headerSize);
+  memcpy(out.data() + headerSize, meshlets.vertices.data(), vertexSize);
+  memcpy(out.data() + headerSize + vertexSize, meshlets.triangles.data(),
+         meshlets.triangles.size());
+  return out;
+}
+
+}  // namespace engine::meshbuilder
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "Mesh.h"
+#include "package/PackageFormat.h"
+
+namespace engine::meshbuilder {
+
+struct Meshlets {
+  std::vector<package::MeshletDesc> meshlets;
+  std::vector<uint32_t> vertices;  // indices into the mesh vertex buffer
+  std::vector<uint8_t> triangles;  // meshlet-local corners
+};
+
+// Greedily partitions |indices| into meshlets in index order, so a
+// cache-optimized index buffer yields spatially coherent meshlets.
+Meshlets buildMeshlets(Mesh const& mesh, std::vector<uint32_t> const& indices,
+                       uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
+
+// Serializes the meshlets as a MESHLETS chunk payload.
+std::vector<uint8_t> packMeshlets(Meshlets const& meshlets,
+                                  package::MeshletsDesc& desc,
+                                  uint32_t maxVertices, uint32_t maxTriangles);
+
+}  // namespace engine::meshbuilder
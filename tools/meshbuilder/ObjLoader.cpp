@@ -0,0 +1,183 @@
+#include "ObjLoader.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+namespace engine::meshbuilder {
+
+namespace {
+
+using VertexKey = std::tuple<int32_t, int32_t, int32_t>;
+
+struct ObjState {
+  std::vector<float> positions;
+  std::vector<float> normals;
+  std::vector<float> uvs;
+};
+
+// Resolves a 1-based, possibly negative OBJ index; returns -1 if absent.
+int32_t resolveIndex(char const* token, size_t count) {
+  if (!*token || *token == '/') {
+    return -1;
+  }
+  long index = strtol(token, nullptr, 10);
+  index = index > 0 ? index - 1 : static_cast<long>(count) + index;
+  if (index < 0 || index >= static_cast<long>(count)) {
+    return -1;
+  }
+  return static_cast<int32_t>(index);
+}
+
+VertexKey parseCorner(char const* token, ObjState const& state) {
+  int32_t const v = resolveIndex(token, state.positions.size() / 3);
+  int32_t vt = -1;
+  int32_t vn = -1;
+  if (char const* slash = strchr(token, '/')) {
+    vt = resolveIndex(slash + 1, state.uvs.size() / 2);
+    if (char const* slash2 = strchr(slash + 1, '/')) {
+      vn = resolveIndex(slash2 + 1, state.normals.size() / 3);
+    }
+  }
+  return {v, vt, vn};
+}
+
+void generateNormals(Mesh& mesh) {
+  for (auto& v : mesh.vertices) {
+    v.normal[0] = v.normal[1] = v.normal[2] = 0.0f;
+  }
+  auto const& indices = mesh.lods[0];
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    float const* a = mesh.vertices[indices[i + 0]].position;
+    float const* b = mesh.vertices[indices[i + 1]].position;
+    float const* c = mesh.vertices[indices[i + 2]].position;
+    float const e0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    float const e1[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    // Unnormalized, so larger faces contribute more.
+    float const n[3] = {e0[1] * e1[2] - e0[2] * e1[1],
+                        e0[2] * e1[0] - e0[0] * e1[2],
+                        e0[0] * e1[1] - e0[1] * e1[0]};
+    for (size_t k = 0; k < 3; ++k) {
+      float* dst = mesh.vertices[indices[i + k]].normal;
+      dst[0] += n[0];
+      dst[1] += n[1];
+      dst[2] += n[2];
+    }
+  }
+  for (auto& v : mesh.vertices) {
+    float const length = sqrtf(v.normal[0] * v.normal[0] +
+                               v.normal[1] * v.normal[1] +
+                               v.normal[2] * v.normal[2]);
+    if (length > 0.0f) {
+      v.normal[0] /= length;
+      v.normal[1] /= length;
+      v.normal[2] /= length;
+    } else {
+      v.normal[2] = 1.0f;
+    }
+  }
+}
+
+}  // anonymous namespace
+
+bool loadObj(char const* path, std::vector<Mesh>& meshes) {
+  std::ifstream in(path);
+  if (!in) {
+    fprintf(stderr, "Unable to open %s\n", path);
+    return false;
+  }
+
+  ObjState state;
+  Mesh current;
+  current.name = "mesh";
+  current.lods.resize(1);
+  std::map<VertexKey, uint32_t> vertexMap;
+  bool missingNormals = false;
+
+  auto flush = [&]() {
+    if (!current.lods[0].empty()) {
+      if (missingNormals) {
+        generateNormals(current);
+      }
+      meshes.push_back(std::move(current));
+    }
+    current = {};
+    current.lods.resize(1);
+    vertexMap.clear();
+    missingNormals = false;
+  };
+
+  std::string line;
+  std::vector<uint32_t> face;
+  while (std::getline(in, line)) {
+    char const* s = line.c_str();
+    while (*s == ' ' || *s == '\t') {
+      ++s;
+    }
+    if (s[0] == 'v' && s[1] == ' ') {
+      float p[3] = {};
+      sscanf(s + 2, "%f %f %f", &p[0], &p[1], &p[2]);
+      state.positions.insert(state.positions.end(), p, p + 3);
+    } else if (s[0] == 'v' && s[1] == 'n') {
+      float n[3] = {};
+      sscanf(s + 3, "%f %f %f", &n[0], &n[1], &n[2]);
+      state.normals.insert(state.normals.end(), n, n + 3);
+    } else if (s[0] == 'v' && s[1] == 't') {
+      float t[2] = {};
+      sscanf(s + 3, "%f %f", &t[0], &t[1]);
+      state.uvs.insert(state.uvs.end(), t, t + 2);
+    } else if ((s[0] == 'o' || s[0] == 'g') && s[1] == ' ') {
+      std::string name(s + 2);
+      name.erase(name.find_last_not_of(" \t\r") + 1);
+      flush();
+      current.name = name.empty() ? "mesh" : name;
+    } else if (s[0] == 'f' && s[1] == ' ') {
+      face.clear();
+      std::istringstream tokens(s + 2);
+      std::string token;
+      while (tokens >> token) {
+        VertexKey const key = parseCorner(token.c_str(), state);
+        if (std::get<0>(key) < 0) {
+          fprintf(stderr, "%s: invalid face index '%s'\n", path,
+                  token.c_str());
+          return false;
+        }
+        auto [it, inserted] = vertexMap.emplace(
+            key, static_cast<uint32_t>(current.vertices.size()));
+        if (inserted) {
+          Vertex v{};
+          memcpy(v.position, &state.positions[std::get<0>(key) * 3],
+                 sizeof(v.position));
+          if (std::get<1>(key) >= 0) {
+            memcpy(v.uv, &state.uvs[std::get<1>(key) * 2], sizeof(v.uv));
+          }
+          if (std::get<2>(key) >= 0) {
+            memcpy(v.normal, &state.normals[std::get<2>(key) * 3],
+                   sizeof(v.normal));
+          } else {
+            missingNormals = true;
+          }
+          current.vertices.push_back(v);
+        }
+        face.push_back(it->second);
+      }
+      // Fan triangulation; OBJ polygons are expected to be convex.
+      for (size_t i = 2; i < face.size(); ++i) {
+        current.lods[0].push_back(face[0]);
+        current.lods[0].push_back(face[i - 1]);
+        current.lods[0].push_back(face[i]);
+      }
+    }
+  }
+  flush();
+  return true;
+}
+
+}  // namespace engine::meshbuilder
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+
+#include "Mesh.h"
+
+namespace engine::meshbuilder {
+
+// Loads a Wavefront OBJ file. Every object or group becomes its own mesh with
+// de-duplicated vertices and a single triangulated LOD.
+bool loadObj(char const* path, std::vector<Mesh>& meshes);
+
+}  // namespace engine::meshbuilder
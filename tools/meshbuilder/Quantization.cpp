@@ -0,0 +1,145 @@
+#include "Quantization.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace engine::meshbuilder {
+
+using namespace engine::package;
+
+namespace {
+
+int16_t toSnorm16(float value) {
+  float const clamped = std::min(std::max(value, -1.0f), 1.0f);
+  return static_cast<int16_t>(lroundf(clamped * 32767.0f));
+}
+
+}  // anonymous namespace
+
+uint16_t floatToHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint32_t const sign = (bits >> 16) & 0x8000;
+  int32_t const exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127;
+  uint32_t mantissa = bits & 0x7fffff;
+
+  if (exponent == 128) {
+    // Infinity or NaN.
+    return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+  }
+  if (exponent > 15) {
+    return static_cast<uint16_t>(sign | 0x7c00);
+  }
+  if (exponent >= -14) {
+    // Round to nearest even on the 13 dropped mantissa bits.
+    uint32_t half = sign | ((exponent + 15) << 10) | (mantissa >> 13);
+    uint32_t const rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+      half++;
+    }
+    return static_cast<uint16_t>(half);
+  }
+  if (exponent >= -25) {
+    mantissa |= 0x800000;
+    uint32_t const shift = static_cast<uint32_t>(-exponent - 1);
+    uint32_t half = mantissa >> shift;
+    uint32_t const rest = mantissa & ((1u << shift) - 1);
+    uint32_t const halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1))) {
+      half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+  }
+  return static_cast<uint16_t>(sign);
+}
+
+void encodeOctahedral(float const normal[3], float out[2]) {
+  float const l1 = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+  if (l1 == 0.0f) {
+    out[0] = 0.0f;
+    out[1] = 0.0f;
+    return;
+  }
+  float x = normal[0] / l1;
+  float y = normal[1] / l1;
+  if (normal[2] < 0.0f) {
+    float const ox = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+    float const oy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    x = ox;
+    y = oy;
+  }
+  out[0] = x;
+  out[1] = y;
+}
+
+std::vector<uint8_t> packVertices(Mesh const& mesh, bool quantize,
+                                  VertexBufferDesc& desc) {
+  desc = {};
+  desc.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+  desc.attributeCount = 3;
+  desc.positionScale[0] = desc.positionScale[1] = desc.positionScale[2] = 1.0f;
+
+  if (!quantize) {
+    desc.stride = sizeof(Vertex);
+    desc.attributes[0] = {VertexSemantic::POSITION, VertexFormat::FLOAT3,
+                          offsetof(Vertex, position)};
+    desc.attributes[1] = {VertexSemantic::NORMAL, VertexFormat::FLOAT3,
+                          offsetof(Vertex, normal)};
+    desc.attributes[2] = {VertexSemantic::UV0, VertexFormat::FLOAT2,
+                          offsetof(Vertex, uv)};
+    std::vector<uint8_t> out(mesh.vertices.size() * sizeof(Vertex));
+    memcpy(out.data(), mesh.vertices.data(), out.size());
+    return out;
+  }
+
+  float lo[3] = {INFINITY, INFINITY, INFINITY};
+  float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+  for (auto const& v : mesh.vertices) {
+    for (int a = 0; a < 3; ++a) {
+      lo[a] = std::min(lo[a], v.position[a]);
+      hi[a] = std::max(hi[a], v.position[a]);
+    }
+  }
+  for (int a = 0; a < 3; ++a) {
+    desc.positionBias[a] = (lo[a] + hi[a]) * 0.5f;
+    desc.positionScale[a] = std::max((hi[a] - lo[a]) * 0.5f, 1e-20f);
+  }
+
+  struct PackedVertex {
+    int16_t position[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+  };
+  static_assert(sizeof(PackedVertex) == 16);
+
+  desc.stride = sizeof(PackedVertex);
+  desc.attributes[0] = {VertexSemantic::POSITION, VertexFormat::SHORT4_NORM,
+                        offsetof(PackedVertex, position)};
+  desc.attributes[1] = {VertexSemantic::NORMAL, VertexFormat::SHORT2_NORM,
+                        offsetof(PackedVertex, normal)};
+  desc.attributes[2] = {VertexSemantic::UV0, VertexFormat::HALF2,
+                        offsetof(PackedVertex, uv)};
+
+  std::vector<uint8_t> out(mesh.vertices.size() * sizeof(PackedVertex));
+  PackedVertex* packed = reinterpret_cast<PackedVertex*>(out.data());
+  for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+    Vertex const& v = mesh.vertices[i];
+    for (int a = 0; a < 3; ++a) {
+      packed[i].position[a] = toSnorm16((v.position[a] - desc.positionBias[a]) /
+                                        desc.positionScale[a]);
+    }
+    packed[i].position[3] = 32767;
+    float oct[2];
+    encodeOctahedral(v.normal, oct);
+    packed[i].normal[0] = toSnorm16(oct[0]);
+    packed[i].normal[1] = toSnorm16(oct[1]);
+    packed[i].uv[0] = floatToHalf(v.uv[0]);
+    packed[i].uv[1] = floatToHalf(v.uv[1]);
+  }
+  return out;
+}
+
+}  // namespace engine::meshbuilder
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "Mesh.h"
+#include "package/PackageFormat.h"
+
+namespace engine::meshbuilder {
+
+uint16_t floatToHalf(float value);
+
+// Maps a unit vector to the [-1, 1]^2 octahedral parameterization.
+void encodeOctahedral(float const normal[3], float out[2]);
+
+// Packs the vertices into the layout written to the package. Quantized
+// vertices are 16 bytes: SHORT4_NORM position (w = 1), SHORT2_NORM
+// octahedral normal and HALF2 uv. Otherwise vertices stay 32-byte floats.
+std::vector<uint8_t> packVertices(Mesh const& mesh, bool quantize,
+                                  package::VertexBufferDesc& desc);
+
+}  // namespace engine::meshbuilder